@@ -0,0 +1,144 @@
+/*
+ * ARMv7 Performance Monitor Unit cycle counter
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <perf.h>
+#include <asm/armv7.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static inline u32 pmu_read_pmcr(void)
+{
+	u32 val;
+
+	asm volatile ("mrc p15, 0, %0, c9, c12, 0" : "=r" (val));
+	return val;
+}
+
+static inline void pmu_write_pmcr(u32 val)
+{
+	asm volatile ("mcr p15, 0, %0, c9, c12, 0" : : "r" (val));
+}
+
+static inline u32 pmu_read_ccnt(void)
+{
+	u32 val;
+
+	asm volatile ("mrc p15, 0, %0, c9, c13, 0" : "=r" (val));
+	return val;
+}
+
+static inline u32 pmu_read_overflow(void)
+{
+	u32 val;
+
+	asm volatile ("mrc p15, 0, %0, c9, c12, 3" : "=r" (val));
+	return val;
+}
+
+static inline void pmu_clear_overflow(u32 mask)
+{
+	asm volatile ("mcr p15, 0, %0, c9, c12, 3" : : "r" (mask));
+}
+
+/* Reset and start the cycle counter, counting every CPU clock */
+void cycle_counter_init(void)
+{
+	u32 pmcr = pmu_read_pmcr();
+
+	pmcr &= ~PMCR_D;
+	pmcr |= PMCR_E | PMCR_C;
+	pmu_write_pmcr(pmcr);
+
+	/* Enable CCNT and clear any stale overflow */
+	asm volatile ("mcr p15, 0, %0, c9, c12, 1" : : "r" (PMU_CCNT_BIT));
+	pmu_clear_overflow(PMU_CCNT_BIT);
+
+	gd->arch.cycles = 0;
+	gd->arch.cycles_last = 0;
+}
+
+/*
+ * 64 bit CPU cycle count since cycle_counter_init(). CCNT itself is only
+ * 32 bits wide, so it is extended in software. The overflow flag lets us
+ * also account for one complete wrap between two calls, which makes this
+ * safe as long as it is called at least every 2^33 cycles (~8s at 1GHz).
+ */
+unsigned long long get_cycles(void)
+{
+	u32 now = pmu_read_ccnt();
+	u32 last = gd->arch.cycles_last;
+
+	if (pmu_read_overflow() & PMU_CCNT_BIT) {
+		pmu_clear_overflow(PMU_CCNT_BIT);
+		/* counter went all the way around and past last again */
+		if (now >= last)
+			gd->arch.cycles += 1ULL << 32;
+	}
+
+	gd->arch.cycles += (u32)(now - last);
+	gd->arch.cycles_last = now;
+
+	return gd->arch.cycles;
+}
+
+#ifdef CONFIG_CMD_PERF
+/* Common ARMv7 architectural event numbers */
+#define PMU_EVT_L1D_REFILL	0x03
+#define PMU_EVT_BR_MISPRED	0x10
+
+/* Event counter assignment */
+#define PMU_CNT_DMISS		0
+#define PMU_CNT_BMISS		1
+
+static void pmu_set_event(int counter, u32 event)
+{
+	/* PMSELR selects the counter PMXEVTYPER/PMXEVCNTR operate on */
+	asm volatile ("mcr p15, 0, %0, c9, c12, 5" : : "r" (counter));
+	asm volatile ("mcr p15, 0, %0, c9, c13, 1" : : "r" (event));
+}
+
+static u32 pmu_read_event(int counter)
+{
+	u32 val;
+
+	asm volatile ("mcr p15, 0, %0, c9, c12, 5" : : "r" (counter));
+	asm volatile ("mrc p15, 0, %0, c9, c13, 2" : "=r" (val));
+	return val;
+}
+
+void perf_counters_init(void)
+{
+	pmu_set_event(PMU_CNT_DMISS, PMU_EVT_L1D_REFILL);
+	pmu_set_event(PMU_CNT_BMISS, PMU_EVT_BR_MISPRED);
+
+	/* Reset the event counters only, CCNT keeps running */
+	pmu_write_pmcr(pmu_read_pmcr() | PMCR_E | PMCR_P);
+
+	asm volatile ("mcr p15, 0, %0, c9, c12, 1" : : "r" (PMU_CCNT_BIT |
+		      (1 << PMU_CNT_DMISS) | (1 << PMU_CNT_BMISS)));
+}
+
+void perf_counters_read(struct perf_counters *pc)
+{
+	pc->cycles = get_cycles();
+	pc->dcache_miss = pmu_read_event(PMU_CNT_DMISS);
+	pc->branch_miss = pmu_read_event(PMU_CNT_BMISS);
+}
+#endif
@@ -23,8 +23,10 @@
  */
 
 #include <common.h>
+#include <div64.h>
 #include <asm/io.h>
 #include <asm/arch/timer.h>
+#include <asm/armv7.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -57,9 +59,38 @@ int timer_init(void)
 	writel(TIMER_MODE | TIMER_DIV | TIMER_SRC | TIMER_RELOAD | TIMER_EN,
 	       &timer_base->ctl);
 
+	gd->arch.tbu = 0;
+	gd->arch.tbl = 0;
+	gd->arch.lastinc = READ_TIMER();
+
+#ifdef CONFIG_ARMV7_PMU
+	cycle_counter_init();
+#endif
+
 	return 0;
 }
 
+/*
+ * Extend the 32 bit hardware counter to a 64 bit free running count of
+ * 24 MHz ticks kept in tbu:tbl. The counter reloads with TIMER_LOAD_VAL,
+ * so it wraps modulo 2^32 and the unsigned difference is always the
+ * elapsed time, as long as we are called at least once per wrap (~178s).
+ */
+static unsigned long long timer_read_counter(void)
+{
+	ulong now = READ_TIMER();
+	unsigned long long ticks;
+
+	ticks = ((unsigned long long)gd->arch.tbu << 32) | gd->arch.tbl;
+	ticks += (u32)(now - gd->arch.lastinc);
+	gd->arch.lastinc = now;
+
+	gd->arch.tbu = ticks >> 32;
+	gd->arch.tbl = (ulong)ticks;
+
+	return ticks;
+}
+
 /* timer without interrupts */
 ulong get_timer(ulong base)
 {
@@ -68,19 +99,13 @@ ulong get_timer(ulong base)
 
 ulong get_timer_masked(void)
 {
-	/* current tick value */
-	ulong now = TICKS_TO_HZ(READ_TIMER());
-
-	if (now >= gd->arch.lastinc)	/* normal (non rollover) */
-		gd->arch.tbl += (now - gd->arch.lastinc);
-	else {
-		/* rollover */
-		gd->arch.tbl += (TICKS_TO_HZ(TIMER_LOAD_VAL)
-				- gd->arch.lastinc) + now;
-	}
-	gd->arch.lastinc = now;
+	return lldiv(timer_read_counter(), TICKS_PER_HZ);
+}
 
-	return gd->arch.tbl;
+/* microseconds since timer_init(), without the CONFIG_SYS_HZ rounding */
+unsigned long long timer_get_us(void)
+{
+	return lldiv(timer_read_counter(), USEC_TO_COUNT(1));
 }
 
 /* delay x useconds */
@@ -101,11 +126,11 @@ void __udelay(unsigned long usec)
 
 /*
  * This function is derived from PowerPC code (read timebase as long long).
- * On ARM it just returns the timer value.
+ * Here it returns the raw 64 bit count of 24 MHz timer ticks.
  */
 unsigned long long get_ticks(void)
 {
-	return get_timer(0);
+	return timer_read_counter();
 }
 
 /*
@@ -114,7 +139,5 @@ unsigned long long get_ticks(void)
  */
 ulong get_tbclk(void)
 {
-	ulong tbclk;
-	tbclk = CONFIG_SYS_HZ;
-	return tbclk;
+	return TIMER_CLOCK;
 }
@@ -182,4 +182,6 @@ struct i2c {
 /* No relevant status infomation,INT_FLAG = 0 */
 #define TWI_STAT_IDLE		0xf8
 
+int i2c_write_read(uchar chip, uchar *wbuf, int wlen, uchar *rbuf, int rlen);
+
 #endif
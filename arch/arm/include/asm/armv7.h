@@ -67,6 +67,20 @@
 #define CP15DSB	asm volatile ("mcr     p15, 0, %0, c7, c10, 4" : : "r" (0))
 #define CP15DMB	asm volatile ("mcr     p15, 0, %0, c7, c10, 5" : : "r" (0))
 
+/* PMU control register (PMCR) bits */
+#define PMCR_E		(1 << 0)	/* enable all counters */
+#define PMCR_P		(1 << 1)	/* reset event counters */
+#define PMCR_C		(1 << 2)	/* reset cycle counter */
+#define PMCR_D		(1 << 3)	/* cycle counter counts every 64th cycle */
+
+/* Cycle counter bit in PMCNTENSET/PMCNTENCLR/PMOVSR */
+#define PMU_CCNT_BIT	(1 << 31)
+
+#ifdef CONFIG_ARMV7_PMU
+void cycle_counter_init(void);
+unsigned long long get_cycles(void);
+#endif
+
 void v7_outer_cache_enable(void);
 void v7_outer_cache_disable(void);
 void v7_outer_cache_flush_all(void);
@@ -32,6 +32,10 @@ struct arch_global_data {
 	unsigned long tbl;
 	unsigned long lastinc;
 	unsigned long long timer_reset_value;
+#ifdef CONFIG_ARMV7_PMU
+	unsigned long long cycles;
+	unsigned long cycles_last;
+#endif
 	unsigned long tlb_addr;
 	unsigned long tlb_size;
 };
@@ -19,10 +19,19 @@ extern char * strchr(const char * s, int c);
 #endif
 extern void * memcpy(void *, const void *, __kernel_size_t);
 
-#undef __HAVE_ARCH_MEMMOVE
+#ifdef CONFIG_USE_ARCH_MEMMOVE
+#define __HAVE_ARCH_MEMMOVE
+#endif
 extern void * memmove(void *, const void *, __kernel_size_t);
 
-#undef __HAVE_ARCH_MEMCHR
+#ifdef CONFIG_USE_ARCH_MEMCMP
+#define __HAVE_ARCH_MEMCMP
+#endif
+extern int memcmp(const void *, const void *, __kernel_size_t);
+
+#ifdef CONFIG_USE_ARCH_MEMCHR
+#define __HAVE_ARCH_MEMCHR
+#endif
 extern void * memchr(const void *, int, __kernel_size_t);
 
 #undef __HAVE_ARCH_MEMZERO
@@ -126,6 +126,15 @@ void mmu_set_region_dcache_behaviour(u32 start, int size,
  */
 void mmu_page_table_flush(unsigned long start, unsigned long stop);
 
+/**
+ * Enable the D-cache before relocation for U-Boot's image and the
+ * initial RAM only, with the page table at CONFIG_SYS_EARLY_TLB_ADDR
+ *
+ * \param start		start address of the U-Boot image
+ * \param size		size of the image including bss
+ */
+void early_dcache_enable(ulong start, ulong size);
+
 #endif /* __ASSEMBLY__ */
 
 #define arch_align_stack(x) (x)
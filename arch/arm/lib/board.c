@@ -219,8 +219,20 @@ static int mark_bootstage(void)
 	return 0;
 }
 
+#if defined(CONFIG_SYS_EARLY_DCACHE) && !defined(CONFIG_SYS_DCACHE_OFF)
+/* run the rest of board_init_f() with U-Boot and its stack cached */
+static int early_dcache_init(void)
+{
+	early_dcache_enable(_TEXT_BASE, gd->mon_len);
+	return 0;
+}
+#endif
+
 init_fnc_t *init_sequence[] = {
 	arch_cpu_init,		/* basic arch cpu dependent setup , xxx*/
+#if defined(CONFIG_SYS_EARLY_DCACHE) && !defined(CONFIG_SYS_DCACHE_OFF)
+	early_dcache_init,	/* D-cache for U-Boot and the init stack */
+#endif
 	mark_bootstage,		/* xxx */
 	timer_init,		/* initialize timer */
 	env_init,		/* initialize environment */
@@ -283,12 +295,25 @@ void board_init_f(ulong bootflag)
 	addr &= ~(4096 - 1);
 	debug("Top of RAM usable for U-Boot at: %08lx\n", addr);
 
+#ifdef CONFIG_SKIP_RELOCATE_UBOOT
+	/*
+	 * U-Boot is linked at its final address and stays there, malloc
+	 * arena, bd, gd and stack go below it as usual
+	 */
+	if (_TEXT_BASE + gd->mon_len > addr) {
+		printf("U-Boot at %08lx overlaps the TLB at %08lx\n",
+		       _TEXT_BASE, addr);
+		hang();
+	}
+	addr = _TEXT_BASE;
+#else
 	/*
 	 * reserve memory for U-Boot code, data & bss
 	 * round down to next 4 kB limit
 	 */
 	addr -= gd->mon_len;
 	addr &= ~(4096 - 1);
+#endif
 
 	debug("Reserving %ldk for U-Boot at: %08lx\n", gd->mon_len >> 10, addr);
 
@@ -346,6 +371,24 @@ void board_init_f(ulong bootflag)
 		gd->fdt_blob = new_fdt;
 	}
 	memcpy(id, (void *)gd, sizeof(gd_t));
+
+#if defined(CONFIG_SYS_EARLY_DCACHE) && !defined(CONFIG_SYS_DCACHE_OFF)
+	/*
+	 * Write everything back and drop the early page table, the final
+	 * one is built at gd->arch.tlb_addr when the D-cache is enabled
+	 * again (below, or in enable_caches()).
+	 */
+	dcache_disable();
+#endif
+
+#ifdef CONFIG_SYS_RELOC_DCACHE
+	/*
+	 * Let relocate_code() copy and fix up the image with the D-cache
+	 * on. The page table is already at its final place (tlb_addr),
+	 * so board_init_r() keeps using it.
+	 */
+	dcache_enable();
+#endif
 }
 
 /*
@@ -100,21 +100,11 @@ __weak void dram_bank_mmu_setup(int bank)
 	}
 }
 
-/* to activate the MMU we need to set up virtual memory: use 1M areas */
-static inline void mmu_setup(void)
+/* start translating with the page table at gd->arch.tlb_addr */
+static void mmu_enable_table(void)
 {
-	int i;
 	u32 reg;
 
-	arm_init_before_mmu();
-	/* Set up an identity-mapping for all 4GB, rw for everyone */
-	for (i = 0; i < 4096; i++)
-		set_section_dcache(i, DCACHE_OFF);
-
-	for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++) {
-		dram_bank_mmu_setup(i);
-	}
-
 	/* Copy the page table address to cp15 */
 	asm volatile("mcr p15, 0, %0, c2, c0, 0"
 		     : : "r" (gd->arch.tlb_addr) : "memory");
@@ -130,6 +120,23 @@ static inline void mmu_setup(void)
 	set_cr(reg | CR_M);
 }
 
+/* to activate the MMU we need to set up virtual memory: use 1M areas */
+static inline void mmu_setup(void)
+{
+	int i;
+
+	arm_init_before_mmu();
+	/* Set up an identity-mapping for all 4GB, rw for everyone */
+	for (i = 0; i < 4096; i++)
+		set_section_dcache(i, DCACHE_OFF);
+
+	for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++) {
+		dram_bank_mmu_setup(i);
+	}
+
+	mmu_enable_table();
+}
+
 static int mmu_enabled(void)
 {
 	return get_cr() & CR_M;
@@ -203,6 +210,37 @@ int icache_status(void)
 }
 #endif
 
+#if defined(CONFIG_SYS_EARLY_DCACHE) && !defined(CONFIG_SYS_DCACHE_OFF)
+/*
+ * Before relocation: cache U-Boot's image (start, size) and the initial
+ * RAM with its stack and gd, using a temporary page table at
+ * CONFIG_SYS_EARLY_TLB_ADDR. The rest of DRAM stays uncached, memory
+ * sizing has to see its writes reach the chips. board_init_f() turns
+ * the D-cache and MMU off again before relocation.
+ */
+void early_dcache_enable(ulong start, ulong size)
+{
+#if defined(CONFIG_SYS_ARM_CACHE_WRITETHROUGH)
+	enum dcache_option option = DCACHE_WRITETHROUGH;
+#else
+	enum dcache_option option = DCACHE_WRITEBACK;
+#endif
+	int i;
+
+	gd->arch.tlb_addr = CONFIG_SYS_EARLY_TLB_ADDR;
+
+	arm_init_before_mmu();
+	for (i = 0; i < 4096; i++)
+		set_section_dcache(i, DCACHE_OFF);
+	mmu_set_region_dcache_behaviour(start, size, option);
+	mmu_set_region_dcache_behaviour(CONFIG_SYS_INIT_RAM_ADDR,
+					CONFIG_SYS_INIT_RAM_SIZE, option);
+
+	mmu_enable_table();
+	set_cr(get_cr() | CR_C);
+}
+#endif
+
 #ifdef CONFIG_SYS_DCACHE_OFF
 void dcache_enable (void)
 {
@@ -0,0 +1,72 @@
+/*
+ * Block read cache statistics and configuration
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <blkcache.h>
+
+static void blkcache_show(void)
+{
+	struct blkcache_stats stats;
+	unsigned int lines, line_blocks;
+
+	blkcache_get_stats(&stats, &lines, &line_blocks);
+	if (lines)
+		printf("%u lines of %u blocks\n", lines, line_blocks);
+	else
+		puts("disabled\n");
+	printf("hits    %lu\n", stats.hits);
+	printf("misses  %lu (%lu read ahead) in %lu reads\n",
+	       stats.misses, stats.ahead, stats.reads);
+	printf("bypass  %lu\n", stats.bypass);
+}
+
+static int do_blkcache(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	unsigned int lines, line_blocks;
+	struct blkcache_stats stats;
+
+	if (argc == 1 || (argc == 2 && !strcmp(argv[1], "info"))) {
+		blkcache_show();
+		return CMD_RET_SUCCESS;
+	}
+
+	if (argc == 2 && !strcmp(argv[1], "flush")) {
+		blkcache_invalidate(NULL);
+		blkcache_clear_stats();
+		return CMD_RET_SUCCESS;
+	}
+
+	if ((argc == 3 || argc == 4) && !strcmp(argv[1], "size")) {
+		blkcache_get_stats(&stats, &lines, &line_blocks);
+		lines = simple_strtoul(argv[2], NULL, 10);
+		if (argc == 4)
+			line_blocks = simple_strtoul(argv[3], NULL, 10);
+		if (blkcache_configure(lines, line_blocks)) {
+			printf("blocks per line must be 1 to 128\n");
+			return CMD_RET_FAILURE;
+		}
+		return CMD_RET_SUCCESS;
+	}
+
+	return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	blkcache,	4,	0,	do_blkcache,
+	"block device read cache",
+	"[info]\n"
+	"    - show the cache size and hit/miss statistics\n"
+	"blkcache flush\n"
+	"    - drop all cached blocks and clear the statistics\n"
+	"blkcache size <lines> [<blocks per line>]\n"
+	"    - set the number of lines and blocks per line (decimal),\n"
+	"      0 lines disables the cache"
+);
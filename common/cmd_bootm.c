@@ -52,6 +52,14 @@
 #include <fdt_support.h>
 #endif
 
+#ifdef CONFIG_LZO
+#include <linux/lzo.h>
+#endif
+
+#ifdef CONFIG_LZ4
+#include <lz4.h>
+#endif
+
 DECLARE_GLOBAL_DATA_PTR;
 
 #ifndef CONFIG_SYS_BOOTM_LEN
@@ -325,6 +333,77 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 		*load_end = load + image_len;
 		break;
 #endif /* CONFIG_GZIP */
+#ifdef CONFIG_BZIP2
+	case IH_COMP_BZIP2: {
+		int ret = BZ_MEM_ERROR;
+
+		printf("   Uncompressing %s ... ", type_name);
+#ifdef CONFIG_BZIP2_FAST
+		ret = bunzip2(load_buf, &unc_len, image_buf, image_len);
+#endif
+		/*
+		 * The reference decoder needs less memory: if the fast one
+		 * could not get its tables, or is not configured, use it in
+		 * small mode when malloc space is below 4MB.
+		 */
+		if (ret == BZ_MEM_ERROR) {
+			unc_len = CONFIG_SYS_BOOTM_LEN;
+			ret = BZ2_bzBuffToBuffDecompress(load_buf, &unc_len,
+				image_buf, image_len,
+				CONFIG_SYS_MALLOC_LEN < (4096 * 1024), 0);
+		}
+		if (ret != BZ_OK) {
+			printf("BUNZIP2: uncompress or overwrite error %d "
+			       "- must RESET board to recover\n", ret);
+			if (boot_progress)
+				bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
+			return BOOTM_ERR_RESET;
+		}
+
+		*load_end = load + unc_len;
+		break;
+	}
+#endif /* CONFIG_BZIP2 */
+#ifdef CONFIG_LZO
+	case IH_COMP_LZO: {
+		size_t size = unc_len;
+		int ret;
+
+		printf("   Uncompressing %s ... ", type_name);
+
+		ret = lzop_decompress(image_buf, image_len, load_buf, &size);
+		if (ret != LZO_E_OK) {
+			printf("LZO: uncompress or overwrite error %d "
+			      "- must RESET board to recover\n", ret);
+			if (boot_progress)
+				bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
+			return BOOTM_ERR_RESET;
+		}
+
+		*load_end = load + size;
+		break;
+	}
+#endif /* CONFIG_LZO */
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4: {
+		size_t size = unc_len;
+		int ret;
+
+		printf("   Uncompressing %s ... ", type_name);
+
+		ret = ulz4fn(image_buf, image_len, load_buf, &size);
+		if (ret) {
+			printf("LZ4: uncompress or overwrite error %d "
+			      "- must RESET board to recover\n", ret);
+			if (boot_progress)
+				bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
+			return BOOTM_ERR_RESET;
+		}
+
+		*load_end = load + size;
+		break;
+	}
+#endif /* CONFIG_LZ4 */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
 		return BOOTM_ERR_UNIMPLEMENTED;
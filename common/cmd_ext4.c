@@ -96,6 +96,9 @@ int do_ext4_write(cmd_tbl_t *cmdtp, int flag, int argc,
 	/* get the filesize in base 10 format */
 	file_size = simple_strtoul(argv[5], NULL, 10);
 
+	/* the write changes the filesystem and the ext4 driver state */
+	fs_invalidate(dev_desc);
+
 	/* set the device as block device */
 	ext4fs_set_blk_dev(dev_desc, &info);
 
@@ -84,6 +84,8 @@ static int do_fat_fsinfo(cmd_tbl_t *cmdtp, int flag, int argc,
 		return 1;
 
 	dev = dev_desc->dev;
+	/* fat_set_blk_dev() replaces the state of a mounted FAT volume */
+	fs_invalidate(dev_desc);
 	if (fat_set_blk_dev(dev_desc, &info) != 0) {
 		printf("\n** Unable to use %s %d:%d for fatinfo **\n",
 			argv[1], dev, part);
@@ -120,6 +122,8 @@ static int do_fat_fswrite(cmd_tbl_t *cmdtp, int flag,
 
 	dev = dev_desc->dev;
 
+	/* the write changes the volume and the state of the FAT driver */
+	fs_invalidate(dev_desc);
 	if (fat_set_blk_dev(dev_desc, &info) != 0) {
 		printf("\n** Unable to use %s %d:%d for fatwrite **\n",
 			argv[1], dev, part);
@@ -36,6 +36,9 @@
 #include <watchdog.h>
 #include <asm/io.h>
 #include <linux/compiler.h>
+#ifdef CONFIG_SYS_MEMTEST_BURST
+#include <div64.h>
+#endif
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -911,6 +914,271 @@ static ulong mem_test_quick(vu_long *buf, ulong start_addr, ulong end_addr,
 	return 0;
 }
 
+#ifdef CONFIG_SYS_MEMTEST_BURST
+/*
+ * Burst memory test, selected with "mtest.f". Unlike the tests above it
+ * runs through the data cache: every pattern is streamed out with
+ * multi-word stores, the cache is flushed so the data really reaches
+ * DRAM, then invalidated and read back with multi-word loads.
+ *
+ * Linear patterns (word i = val + i * incr) go through the fill/check
+ * kernels below, which architectures may replace by faster ones
+ * (arch/arm/lib/memtest.S). Ranges are processed in chunks of
+ * MTEST_BURST_CHUNK bytes so the watchdog and ctrl-c are still serviced.
+ */
+#define MTEST_BURST_CHUNK	(1 << 20)
+#define MTEST_BURST_MAX_ERRS	32
+
+enum {
+	MTEST_BURST_LINEAR,	/* word i = val + i * incr */
+	MTEST_BURST_WALK,	/* word i = (1 << ((incr + i) % 32)) ^ val */
+	MTEST_BURST_RANDOM,	/* xorshift32 sequence seeded with val */
+};
+
+void __mtest_burst_fill(ulong *buf, ulong *end, ulong val, ulong incr)
+{
+	while (buf < end) {
+		buf[0] = val;
+		buf[1] = val + incr;
+		buf[2] = val + 2 * incr;
+		buf[3] = val + 3 * incr;
+		buf[4] = val + 4 * incr;
+		buf[5] = val + 5 * incr;
+		buf[6] = val + 6 * incr;
+		buf[7] = val + 7 * incr;
+		val += 8 * incr;
+		buf += 8;
+	}
+}
+void mtest_burst_fill(ulong *buf, ulong *end, ulong val, ulong incr)
+	__attribute__((weak, alias("__mtest_burst_fill")));
+
+ulong *__mtest_burst_check(ulong *buf, ulong *end, ulong val, ulong incr)
+{
+	int i;
+
+	for (; buf < end; buf += 8) {
+		for (i = 0; i < 8; i++, val += incr)
+			if (buf[i] != val)
+				return buf;
+	}
+
+	return end;
+}
+ulong *mtest_burst_check(ulong *buf, ulong *end, ulong val, ulong incr)
+	__attribute__((weak, alias("__mtest_burst_check")));
+
+static ulong mtest_burst_mbps(ulong bytes, unsigned long long usec)
+{
+	if (usec == 0 || usec > 0xffffffffULL)
+		return 0;
+
+	return (ulong)lldiv(bytes, (u32)usec);
+}
+
+static int mtest_burst_error(ulong start_addr, ulong *buf, ulong *addr,
+			     ulong found, ulong expected, ulong *errs)
+{
+	if (++(*errs) <= MTEST_BURST_MAX_ERRS)
+		printf("\nMem error @ 0x%08lX: found %08lX, expected %08lX",
+		       start_addr + (addr - buf) * sizeof(ulong), found,
+		       expected);
+	else if (*errs == MTEST_BURST_MAX_ERRS + 1)
+		puts("\n(further errors not shown)");
+
+	return ctrlc() ? -1 : 0;
+}
+
+static ulong mtest_burst_linear(ulong start_addr, ulong *buf, ulong *end,
+				ulong val, ulong incr, ulong *errs,
+				int verify)
+{
+	ulong *p, *stop, *bad;
+	int i;
+
+	for (p = buf; p < end; p = stop) {
+		WATCHDOG_RESET();
+		if (ctrlc())
+			return -1;
+
+		stop = p + MTEST_BURST_CHUNK / sizeof(ulong);
+		if (stop > end)
+			stop = end;
+
+		if (!verify) {
+			mtest_burst_fill(p, stop, val + (p - buf) * incr, incr);
+			continue;
+		}
+
+		while (p < stop) {
+			bad = mtest_burst_check(p, stop, val + (p - buf) * incr,
+						incr);
+			if (bad == stop)
+				break;
+
+			/* pin down the failing words of this block */
+			for (i = 0; i < 8; i++) {
+				ulong expected = val + (bad + i - buf) * incr;
+
+				if (bad[i] != expected &&
+				    mtest_burst_error(start_addr, buf, bad + i,
+						      bad[i], expected, errs))
+					return -1;
+			}
+			p = bad + 8;
+		}
+	}
+
+	return 0;
+}
+
+static ulong mtest_burst_random(ulong start_addr, ulong *buf, ulong *end,
+				ulong seed, ulong *errs, int verify)
+{
+	ulong *p;
+	u32 x = seed ? seed : 0x2545f491;
+
+	for (p = buf; p < end; p++) {
+		if (((ulong)p & (MTEST_BURST_CHUNK - 1)) == 0) {
+			WATCHDOG_RESET();
+			if (ctrlc())
+				return -1;
+		}
+
+		/* xorshift32 */
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+
+		if (!verify)
+			*p = x;
+		else if (*p != x &&
+			 mtest_burst_error(start_addr, buf, p, *p, x, errs))
+			return -1;
+	}
+
+	return 0;
+}
+
+/* Walking ones/zeros, the bit moves on with every word */
+static ulong mtest_burst_walk(ulong start_addr, ulong *buf, ulong *end,
+			      ulong invert, ulong bit, ulong *errs, int verify)
+{
+	ulong *p;
+	ulong x;
+
+	for (p = buf; p < end; p++, bit++) {
+		if (((ulong)p & (MTEST_BURST_CHUNK - 1)) == 0) {
+			WATCHDOG_RESET();
+			if (ctrlc())
+				return -1;
+		}
+
+		x = (1UL << (bit % 32)) ^ invert;
+
+		if (!verify)
+			*p = x;
+		else if (*p != x &&
+			 mtest_burst_error(start_addr, buf, p, *p, x, errs))
+			return -1;
+	}
+
+	return 0;
+}
+
+static ulong mtest_burst_run(int mode, ulong start_addr, ulong *buf,
+			     ulong *end, ulong val, ulong incr, ulong *errs,
+			     int verify)
+{
+	switch (mode) {
+	case MTEST_BURST_WALK:
+		return mtest_burst_walk(start_addr, buf, end, val, incr,
+					errs, verify);
+	case MTEST_BURST_RANDOM:
+		return mtest_burst_random(start_addr, buf, end, val, errs,
+					  verify);
+	default:
+		return mtest_burst_linear(start_addr, buf, end, val, incr,
+					  errs, verify);
+	}
+}
+
+/* Fill, flush, invalidate and verify one pattern, printing bandwidth */
+static ulong mtest_burst_pass(const char *name, ulong start_addr,
+			      ulong *buf, ulong *end, int mode, ulong val,
+			      ulong incr, ulong *errs)
+{
+	ulong bytes = (end - buf) * sizeof(ulong);
+	unsigned long long t0, t1, t2;
+	ulong ret;
+
+	printf("  %-14s", name);
+
+	t0 = timer_get_us();
+	ret = mtest_burst_run(mode, start_addr, buf, end, val, incr, errs, 0);
+	if (ret)
+		return ret;
+	flush_dcache_range((ulong)buf, (ulong)end);
+	t1 = timer_get_us();
+
+	invalidate_dcache_range((ulong)buf, (ulong)end);
+	ret = mtest_burst_run(mode, start_addr, buf, end, val, incr, errs, 1);
+	if (ret)
+		return ret;
+	t2 = timer_get_us();
+
+	printf("write %5lu MB/s  read %5lu MB/s\n",
+	       mtest_burst_mbps(bytes, t1 - t0),
+	       mtest_burst_mbps(bytes, t2 - t1));
+
+	return 0;
+}
+
+static ulong mem_test_burst(vu_long *vbuf, ulong start_addr, ulong end_addr,
+			    ulong seed, int iteration)
+{
+	ulong *buf = (ulong *)vbuf;
+	ulong *end;
+	ulong first, last;
+	ulong errs = 0;
+
+	/*
+	 * Only whole cache lines: the flush and invalidate would leave
+	 * partial lines at either end in the cache and the verify pass
+	 * would read those back instead of DRAM. This also keeps the
+	 * kernels on whole 32 byte blocks.
+	 */
+	first = ALIGN(start_addr, ARCH_DMA_MINALIGN);
+	last = end_addr & ~(ARCH_DMA_MINALIGN - 1);
+	if (last <= first)
+		return 0;
+	buf += (first - start_addr) / sizeof(ulong);
+	end = buf + (last - first) / sizeof(ulong);
+	start_addr = first;
+
+	putc('\n');
+	if (mtest_burst_pass("walking ones", start_addr, buf, end,
+			     MTEST_BURST_WALK, 0, iteration, &errs) ||
+	    mtest_burst_pass("walking zeros", start_addr, buf, end,
+			     MTEST_BURST_WALK, ~0UL, iteration, &errs) ||
+	    mtest_burst_pass("checkerboard", start_addr, buf, end,
+			     MTEST_BURST_LINEAR, 0x55555555, 0, &errs) ||
+	    mtest_burst_pass("inverse check", start_addr, buf, end,
+			     MTEST_BURST_LINEAR, 0xaaaaaaaa, 0, &errs) ||
+	    mtest_burst_pass("address", start_addr, buf, end,
+			     MTEST_BURST_LINEAR, start_addr, sizeof(ulong),
+			     &errs) ||
+	    mtest_burst_pass("inverse addr", start_addr, buf, end,
+			     MTEST_BURST_LINEAR, ~start_addr, -sizeof(ulong),
+			     &errs) ||
+	    mtest_burst_pass("random", start_addr, buf, end,
+			     MTEST_BURST_RANDOM, seed + iteration, 0, &errs))
+		return -1;
+
+	return errs;
+}
+#endif /* CONFIG_SYS_MEMTEST_BURST */
+
 /*
  * Perform a memory test. A more complete alternative test can be
  * configured using CONFIG_SYS_ALT_MEMTEST. The complete test loops until
@@ -931,6 +1199,10 @@ static int do_mem_mtest(cmd_tbl_t *cmdtp, int flag, int argc,
 #else
 	const int alt_test = 0;
 #endif
+#ifdef CONFIG_SYS_MEMTEST_BURST
+	const char *suffix = strchr(argv[0], '.');
+	int burst_test = suffix && suffix[1] == 'f';
+#endif
 
 	if (argc > 1)
 		start = simple_strtoul(argv[1], NULL, 16);
@@ -968,6 +1240,12 @@ static int do_mem_mtest(cmd_tbl_t *cmdtp, int flag, int argc,
 
 		printf("Iteration: %6d\r", iteration + 1);
 		debug("\n");
+#ifdef CONFIG_SYS_MEMTEST_BURST
+		if (burst_test) {
+			errs = mem_test_burst(buf, start, end, pattern,
+					      iteration);
+		} else
+#endif
 		if (alt_test) {
 			errs = mem_test_alt(buf, start, end, dummy);
 		} else {
@@ -1246,6 +1524,12 @@ U_BOOT_CMD(
 	mtest,	5,	1,	do_mem_mtest,
 	"simple RAM read/write test",
 	"[start [end [pattern [iterations]]]]"
+#ifdef CONFIG_SYS_MEMTEST_BURST
+	"\nmtest.f [start [end [seed [iterations]]]]\n"
+	"    - cached burst test (walking 1/0, checkerboard, address,\n"
+	"      random) reporting bandwidth; only whole cache lines are\n"
+	"      tested, start is rounded up and end down to a line"
+#endif
 );
 #endif	/* CONFIG_CMD_MEMTEST */
 
@@ -0,0 +1,321 @@
+/*
+ * Check the string functions against byte-wise references and measure
+ * their bandwidth, to validate and compare the architecture versions
+ * selected with CONFIG_USE_ARCH_MEM*
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <command.h>
+#include <div64.h>
+#include <malloc.h>
+
+#define MEMBENCH_GUARD		32	/* bytes checked on each side */
+#define MEMBENCH_FILL		0xa5
+
+/* Byte-wise references, deliberately not using the functions tested */
+static void ref_memmove(uchar *d, const uchar *s, ulong n)
+{
+	if (d <= s) {
+		while (n--)
+			*d++ = *s++;
+	} else {
+		while (n--)
+			d[n] = s[n];
+	}
+}
+
+static int ref_memcmp(const uchar *a, const uchar *b, ulong n)
+{
+	for (; n; n--, a++, b++)
+		if (*a != *b)
+			return *a - *b;
+	return 0;
+}
+
+static const uchar *ref_memchr(const uchar *s, int c, ulong n)
+{
+	for (; n; n--, s++)
+		if (*s == (uchar)c)
+			return s;
+	return NULL;
+}
+
+static uint32_t membench_seed;
+
+/* keeps the timed memcmp/memchr calls from being optimised away */
+static volatile int membench_sink;
+
+static uchar membench_rand(void)
+{
+	membench_seed = membench_seed * 1103515245 + 12345;
+	return membench_seed >> 16;
+}
+
+static void membench_fill(uchar *buf, ulong n)
+{
+	while (n--)
+		*buf++ = membench_rand();
+}
+
+static int membench_fail(const char *name, int off1, int off2, ulong len)
+{
+	printf("%s: mismatch at offsets %d/%d, length %lu\n",
+	       name, off1, off2, len);
+	return 1;
+}
+
+/*
+ * Copy len bytes from src + s to src + d in one buffer (overlapping if
+ * the offsets are close) or to a second buffer, and compare everything
+ * including the guard bytes with the reference.
+ */
+static int membench_check_copy(uchar *buf, uchar *ref, ulong size,
+			       int s, int d, ulong len, int move)
+{
+	ulong total = size + 2 * MEMBENCH_GUARD;
+	uchar *dst, *rdst;
+	void *ret;
+
+	membench_fill(buf, total);
+	memcpy(ref, buf, total);
+	memset(buf + total, MEMBENCH_FILL, total);
+	memset(ref + total, MEMBENCH_FILL, total);
+
+	if (move) {
+		dst = buf + MEMBENCH_GUARD + d;
+		rdst = ref + MEMBENCH_GUARD + d;
+		ret = memmove(dst, buf + MEMBENCH_GUARD + s, len);
+		ref_memmove(rdst, ref + MEMBENCH_GUARD + s, len);
+	} else {
+		dst = buf + total + MEMBENCH_GUARD + d;
+		rdst = ref + total + MEMBENCH_GUARD + d;
+		ret = memcpy(dst, buf + MEMBENCH_GUARD + s, len);
+		ref_memmove(rdst, ref + MEMBENCH_GUARD + s, len);
+	}
+
+	if (ret != dst || ref_memcmp(buf, ref, 2 * total))
+		return membench_fail(move ? "memmove" : "memcpy", s, d, len);
+
+	return 0;
+}
+
+static int membench_check_cmp(uchar *a, uchar *b, ulong size, int s, int d,
+			      ulong len)
+{
+	const uchar *found;
+	ulong i;
+	int r1, r2;
+
+	membench_fill(a + s, len);
+	memcpy(b + d, a + s, len);
+
+	/* equal, then a difference at the start, the end and in between */
+	for (i = 0; i < 4 && len; i++) {
+		ulong pos = i == 1 ? 0 : i == 2 ? len - 1 : membench_rand() % len;
+
+		if (i)
+			b[d + pos] ^= 1 << (membench_rand() & 7);
+		r1 = memcmp(a + s, b + d, len);
+		r2 = ref_memcmp(a + s, b + d, len);
+		if (r1 != r2)
+			return membench_fail("memcmp", s, d, len);
+		b[d + pos] = a[s + pos];
+	}
+	if (!len && memcmp(a + s, b + d, 0))
+		return membench_fail("memcmp", s, d, len);
+
+	/* a byte with the top bit set, absent and present once */
+	membench_fill(a + s, len);
+	for (i = 0; i < len; i++)
+		if (a[s + i] == 0x80)
+			a[s + i] = 0x7f;
+	if (memchr(a + s, 0x180, len))
+		return membench_fail("memchr", s, d, len);
+	if (len) {
+		i = membench_rand() % len;
+		a[s + i] = 0x80;
+		found = ref_memchr(a + s, 0x80, len);
+		if (memchr(a + s, 0x180, len) != found)
+			return membench_fail("memchr", s, d, len);
+	}
+
+	return 0;
+}
+
+static int membench_check(ulong size)
+{
+	ulong total = size + 2 * MEMBENCH_GUARD;
+	uchar *buf, *ref;
+	ulong len;
+	int s, d, err = 0;
+
+	buf = malloc(2 * total);
+	ref = malloc(2 * total);
+	if (!buf || !ref) {
+		printf("membench: out of memory\n");
+		free(buf);
+		free(ref);
+		return 1;
+	}
+
+	membench_seed = 1;
+	for (len = 0; len <= size - 8 && !err; len += len < 64 ? 1 : 7) {
+		for (s = 0; s < 8 && !err; s++) {
+			for (d = 0; d < 8 && !err; d++) {
+				err = membench_check_copy(buf, ref, size, s, d,
+							  len, 0);
+				if (!err)
+					err = membench_check_cmp(buf,
+						buf + total, size, s, d, len);
+			}
+		}
+
+		/* overlapping moves in both directions */
+		for (s = 0; s < 8 && !err; s++) {
+			for (d = 0; d < 8 && !err; d++) {
+				err = membench_check_copy(buf, ref, size,
+							  s, d, len, 1);
+				if (err || len + 72 > size)
+					continue;
+				/* far enough apart for the block loops */
+				err = membench_check_copy(buf, ref, size,
+							  s, d + 64, len, 1);
+				if (!err)
+					err = membench_check_copy(buf, ref,
+						size, s + 64, d, len, 1);
+			}
+		}
+
+		if (ctrlc()) {
+			puts("\nAbort\n");
+			err = 1;
+		}
+	}
+
+	free(buf);
+	free(ref);
+
+	return err;
+}
+
+static void membench_report(const char *name, ulong bytes, ulong loops,
+			    unsigned long long us)
+{
+	unsigned long long total = (unsigned long long)bytes * loops;
+
+	if (!us)
+		us = 1;
+	printf("%-16s %8llu us %8llu MB/s\n", name, us,
+	       lldiv(total, (u32)us));
+}
+
+static void membench_speed(uchar *base, ulong size, ulong loops)
+{
+	uchar *a = base, *b = base + size;
+	unsigned long long start;
+	ulong i;
+
+	memset(a, MEMBENCH_FILL, 2 * size);
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		memset(a, i, size);
+	membench_report("memset", size, loops, timer_get_us() - start);
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		memcpy(b, a, size);
+	membench_report("memcpy", size, loops, timer_get_us() - start);
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		memcpy(b + 1, a + 2, size - 8);
+	membench_report("memcpy unaligned", size - 8, loops,
+			timer_get_us() - start);
+
+	/* overlapping by all but 64 bytes, the worst case for memmove */
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		memmove(a, a + 64, size);
+	membench_report("memmove down", size, loops, timer_get_us() - start);
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		memmove(a + 64, a, size);
+	membench_report("memmove up", size, loops, timer_get_us() - start);
+
+	memcpy(b, a, size);
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		membench_sink = memcmp(a, b, size);
+	membench_report("memcmp", size, loops, timer_get_us() - start);
+
+	memset(a, 0, size);
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		membench_sink = memchr(a, 1, size) != NULL;
+	membench_report("memchr", size, loops, timer_get_us() - start);
+}
+
+static int do_membench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	ulong addr, size, loops;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	if (!strcmp(argv[1], "check")) {
+		if (argc > 3)
+			return CMD_RET_USAGE;
+		size = argc > 2 ? simple_strtoul(argv[2], NULL, 10) : 256;
+		if (size < 16)
+			size = 16;
+		if (membench_check(size))
+			return CMD_RET_FAILURE;
+		puts("memcpy, memmove, memcmp, memchr: OK\n");
+		return CMD_RET_SUCCESS;
+	}
+
+	if (!strcmp(argv[1], "speed")) {
+		if (argc < 4 || argc > 5)
+			return CMD_RET_USAGE;
+		addr = simple_strtoul(argv[2], NULL, 16);
+		size = simple_strtoul(argv[3], NULL, 16);
+		loops = argc > 4 ? simple_strtoul(argv[4], NULL, 10) : 16;
+		if (size < 128 || !loops)
+			return CMD_RET_USAGE;
+		/* memmove up writes 64 bytes past the first area */
+		membench_speed(map_sysmem(addr, 2 * size + 64), size, loops);
+		return CMD_RET_SUCCESS;
+	}
+
+	return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	membench,	5,	0,	do_membench,
+	"check and time memcpy, memmove, memcmp, memchr and memset",
+	"check [size]\n"
+	"    - compare the string functions with byte-wise references for\n"
+	"      all alignments, lengths up to size (default 256) and\n"
+	"      overlapping moves in both directions\n"
+	"membench speed addr size [loops]\n"
+	"    - print the bandwidth of each function on size bytes (hex)\n"
+	"      at addr; 2 * size + 64 bytes at addr are overwritten"
+);
@@ -0,0 +1,160 @@
+/*
+ * Per-region cycle and event accounting
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <command.h>
+#include <div64.h>
+#include <perf.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+struct perf_region_stats {
+	unsigned int depth;
+	unsigned long calls;
+	unsigned long long cycles;
+	unsigned long long dcache_miss;
+	unsigned long long branch_miss;
+	struct perf_counters start;
+};
+
+static const char * const perf_region_name[PERF_REGION_COUNT] = {
+	[PERF_MMC_BREAD]	= "mmc_bread",
+	[PERF_GUNZIP]		= "gunzip",
+	[PERF_CRC32]		= "crc32",
+	[PERF_SHA256]		= "sha256",
+	[PERF_NET_RECEIVE]	= "NetReceive",
+	[PERF_LZO]		= "lzop",
+	[PERF_LZ4]		= "lz4",
+	[PERF_BUNZIP2]		= "bunzip2",
+};
+
+static struct perf_region_stats perf_stats[PERF_REGION_COUNT];
+static int perf_initialized;
+
+/*
+ * Before relocation .bss overlays the relocation tables, so nothing is
+ * recorded until we run from RAM.
+ */
+static int perf_ready(void)
+{
+	if (!(gd->flags & GD_FLG_RELOC))
+		return 0;
+
+	if (!perf_initialized) {
+		perf_counters_init();
+		perf_initialized = 1;
+	}
+
+	return 1;
+}
+
+void perf_start(enum perf_region region)
+{
+	struct perf_region_stats *ps = &perf_stats[region];
+
+	if (!perf_ready())
+		return;
+
+	/* only the outermost entry counts for recursive regions */
+	if (ps->depth++ == 0)
+		perf_counters_read(&ps->start);
+}
+
+void perf_stop(enum perf_region region)
+{
+	struct perf_region_stats *ps = &perf_stats[region];
+	struct perf_counters now;
+
+	if (!perf_ready() || ps->depth == 0 || --ps->depth != 0)
+		return;
+
+	perf_counters_read(&now);
+	ps->calls++;
+	ps->cycles += now.cycles - ps->start.cycles;
+	ps->dcache_miss += (u32)(now.dcache_miss - ps->start.dcache_miss);
+	ps->branch_miss += (u32)(now.branch_miss - ps->start.branch_miss);
+}
+
+static int perf_cmp_cycles(const void *a, const void *b)
+{
+	const struct perf_region_stats *pa = &perf_stats[*(const int *)a];
+	const struct perf_region_stats *pb = &perf_stats[*(const int *)b];
+
+	if (pa->cycles == pb->cycles)
+		return 0;
+	return pa->cycles < pb->cycles ? 1 : -1;
+}
+
+static void perf_show(void)
+{
+	int order[PERF_REGION_COUNT];
+	int i;
+
+	for (i = 0; i < PERF_REGION_COUNT; i++)
+		order[i] = i;
+	qsort(order, PERF_REGION_COUNT, sizeof(order[0]), perf_cmp_cycles);
+
+	printf("%-12s %8s %14s %12s %12s %12s\n", "region", "calls",
+	       "cycles", "cycles/call", "D-miss", "br-miss");
+	for (i = 0; i < PERF_REGION_COUNT; i++) {
+		struct perf_region_stats *ps = &perf_stats[order[i]];
+
+		printf("%-12s %8lu %14llu %12llu %12llu %12llu\n",
+		       perf_region_name[order[i]], ps->calls, ps->cycles,
+		       ps->calls ? lldiv(ps->cycles, ps->calls) : 0ULL,
+		       ps->dcache_miss, ps->branch_miss);
+	}
+}
+
+static int do_perf(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int i;
+
+	if (argc == 1) {
+		perf_show();
+		return 0;
+	}
+
+	if (argc != 2)
+		return CMD_RET_USAGE;
+
+	if (!strcmp(argv[1], "reset")) {
+		for (i = 0; i < PERF_REGION_COUNT; i++) {
+			/* keep the nesting state of regions we are inside */
+			unsigned int depth = perf_stats[i].depth;
+
+			memset(&perf_stats[i], 0, sizeof(perf_stats[i]));
+			perf_stats[i].depth = depth;
+			if (depth)
+				perf_counters_read(&perf_stats[i].start);
+		}
+		return 0;
+	}
+
+	return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	perf,	2,	1,	do_perf,
+	"show cycle and cache/branch miss counts of profiled code regions",
+	"\n"
+	"    - show accumulated counts, sorted by cycles\n"
+	"perf reset\n"
+	"    - clear all counts"
+);
@@ -0,0 +1,154 @@
+/*
+ * Prepare the kernel arguments (ATAGs or FDT) for an SPL that boots the
+ * kernel directly ("Falcon mode")
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <command.h>
+#include <cmd_spl.h>
+#include <image.h>
+#include <asm/setup.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/*
+ * bootm subcommands that leave the arguments of the kernel in memory
+ * without starting it. The ARM bootm has no cmdline and bdt steps, the
+ * prep step builds the ATAGs or applies the FDT fixups.
+ */
+static const char *const export_fdt_cmds[] = {
+	"start", "loados",
+#ifdef CONFIG_SYS_BOOT_RAMDISK_HIGH
+	"ramdisk",
+#endif
+	"fdt", "prep", NULL
+};
+
+static const char *const export_atags_cmds[] = {
+	"start", "loados",
+#ifdef CONFIG_SYS_BOOT_RAMDISK_HIGH
+	"ramdisk",
+#endif
+	"prep", NULL
+};
+
+static const char *const *const export_cmds[] = {
+	[SPL_EXPORT_FDT] = export_fdt_cmds,
+	[SPL_EXPORT_ATAGS] = export_atags_cmds,
+};
+
+/* run the bootm subcommands, "start" gets the image addresses */
+static int spl_export_bootm(const char *const *cmds, int argc,
+			    char * const argv[])
+{
+	char *bootm_argv[5];
+	int i, ret;
+
+	bootm_argv[0] = "bootm";
+	for (i = 0; i < argc; i++)
+		bootm_argv[i + 2] = argv[i];
+
+	for (i = 0; cmds[i]; i++) {
+		bootm_argv[1] = (char *)cmds[i];
+		ret = do_bootm(find_cmd("bootm"), 0, i ? 2 : argc + 2,
+			       bootm_argv);
+		if (ret) {
+			printf("bootm %s failed\n", cmds[i]);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/* length of the ATAG list at addr, up to and including ATAG_NONE */
+static ulong spl_atags_len(ulong addr)
+{
+	struct tag *t = (struct tag *)addr;
+
+	while (t->hdr.size && t->hdr.tag != ATAG_NONE)
+		t = tag_next(t);
+
+	return (ulong)t + sizeof(struct tag_header) - addr;
+}
+
+static int spl_export(int type, int argc, char * const argv[])
+{
+	ulong addr, len;
+	int ret;
+
+	ret = spl_export_bootm(export_cmds[type], argc, argv);
+	if (ret)
+		return CMD_RET_FAILURE;
+
+	if (type == SPL_EXPORT_FDT) {
+		if (!images.ft_len) {
+			puts("no FDT, use \"spl export atags\"\n");
+			return CMD_RET_FAILURE;
+		}
+		addr = (ulong)images.ft_addr;
+		len = images.ft_len;
+	} else {
+		addr = gd->bd->bi_boot_params;
+		len = spl_atags_len(addr);
+	}
+
+	printf("Argument image is now in RAM at 0x%08lx, %lu bytes\n",
+	       addr, len);
+	setenv_hex("fileaddr", addr);
+	setenv_hex("filesize", len);
+
+#ifdef CONFIG_SYS_MMCSD_RAW_MODE_ARGS_SECTOR
+	if (len > CONFIG_SYS_MMCSD_RAW_MODE_ARGS_SECTORS * 512) {
+		printf("too large for the %d sectors the SPL reads\n",
+		       CONFIG_SYS_MMCSD_RAW_MODE_ARGS_SECTORS);
+		return CMD_RET_FAILURE;
+	}
+	printf("Store it with: mmc write 0x%lx 0x%x 0x%lx\n", addr,
+	       CONFIG_SYS_MMCSD_RAW_MODE_ARGS_SECTOR,
+	       DIV_ROUND_UP(len, 512));
+#endif
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_spl(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int type;
+
+	if (argc < 3 || argc > 6 || strcmp(argv[1], "export"))
+		return CMD_RET_USAGE;
+
+	if (!strcmp(argv[2], "fdt"))
+		type = SPL_EXPORT_FDT;
+	else if (!strcmp(argv[2], "atags"))
+		type = SPL_EXPORT_ATAGS;
+	else
+		return CMD_RET_USAGE;
+
+	return spl_export(type, argc - 3, argv + 3);
+}
+
+U_BOOT_CMD(
+	spl,	6,	0,	do_spl,
+	"SPL configuration",
+	"export <img=atags|fdt> [kernel_addr] [initrd_addr] [fdt_addr]\n"
+	"    - run the bootm steps up to the prepared kernel arguments\n"
+	"      and report their address and size (also in fileaddr and\n"
+	"      filesize), to be stored for a Falcon mode SPL"
+);
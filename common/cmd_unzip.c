@@ -0,0 +1,149 @@
+/*
+ * Decompress a gzip, lzop, lz4 or bzip2 image in memory and report the
+ * throughput, to compare the decompressors available to bootm
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <bzlib.h>
+#include <command.h>
+#include <div64.h>
+#include <image.h>
+#include <lz4.h>
+#include <linux/lzo.h>
+
+static const uchar lzop_magic[] = { 0x89, 'L', 'Z', 'O' };
+static const uchar lz4_magic[] = { 0x04, 0x22, 0x4d, 0x18 };
+static const uchar lz4_legacy_magic[] = { 0x02, 0x21, 0x4c, 0x18 };
+
+/* Guess the compression from the magic number at the start of the data */
+static int unzip_detect(const uchar *src)
+{
+	if (src[0] == 0x1f && src[1] == 0x8b)
+		return IH_COMP_GZIP;
+	if (!memcmp(src, lzop_magic, sizeof(lzop_magic)))
+		return IH_COMP_LZO;
+	if (!memcmp(src, lz4_magic, sizeof(lz4_magic)) ||
+	    !memcmp(src, lz4_legacy_magic, sizeof(lz4_legacy_magic)))
+		return IH_COMP_LZ4;
+	if (src[0] == 'B' && src[1] == 'Z' && src[2] == 'h')
+		return IH_COMP_BZIP2;
+
+	return IH_COMP_NONE;
+}
+
+static int do_unzip(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	ulong src, dst;
+	ulong src_len, dst_len;
+	unsigned long long start, us;
+	uchar *src_buf;
+	void *dst_buf;
+	int comp, ret;
+	__maybe_unused int ref = 0;
+
+	if (argc > 1 && !strcmp(argv[1], "-r")) {
+		ref = 1;
+		argc--;
+		argv++;
+	}
+	if (argc < 3 || argc > 5)
+		return CMD_RET_USAGE;
+
+	src = simple_strtoul(argv[1], NULL, 16);
+	dst = simple_strtoul(argv[2], NULL, 16);
+	dst_len = argc > 3 ? simple_strtoul(argv[3], NULL, 16) : ~0UL - dst;
+	src_len = argc > 4 ? simple_strtoul(argv[4], NULL, 16) : ~0UL - src;
+
+	src_buf = map_sysmem(src, src_len);
+	dst_buf = map_sysmem(dst, dst_len);
+
+	comp = unzip_detect(src_buf);
+	start = timer_get_us();
+
+	switch (comp) {
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		ret = gunzip(dst_buf, dst_len, src_buf, &src_len);
+		dst_len = src_len;
+		break;
+#endif
+#ifdef CONFIG_LZO
+	case IH_COMP_LZO: {
+		size_t size = dst_len;
+
+		ret = lzop_decompress(src_buf, src_len, dst_buf, &size);
+		dst_len = size;
+		break;
+	}
+#endif
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4: {
+		size_t size = dst_len;
+
+		ret = ulz4fn(src_buf, src_len, dst_buf, &size);
+		dst_len = size;
+		break;
+	}
+#endif
+#ifdef CONFIG_BZIP2
+	case IH_COMP_BZIP2: {
+		uint size = dst_len;
+
+#ifdef CONFIG_BZIP2_FAST
+		if (!ref)
+			ret = bunzip2(dst_buf, &size, src_buf, src_len);
+		else
+#endif
+			ret = BZ2_bzBuffToBuffDecompress(dst_buf, &size,
+				(char *)src_buf, src_len,
+				CONFIG_SYS_MALLOC_LEN < (4096 * 1024), 0);
+		dst_len = ret == BZ_OK ? size : 0;
+		break;
+	}
+#endif
+	default:
+		printf("Unsupported or unknown compression at %08lx\n", src);
+		return CMD_RET_FAILURE;
+	}
+
+	us = timer_get_us() - start;
+	if (ret) {
+		printf("%s: error %d after %lu bytes\n",
+		       genimg_get_comp_name(comp), ret, dst_len);
+		return CMD_RET_FAILURE;
+	}
+
+	printf("Uncompressed size: %lu = 0x%lX\n", dst_len, dst_len);
+	if (us)
+		printf("%s: %llu us, %llu KiB/s\n", genimg_get_comp_name(comp),
+		       us, lldiv((unsigned long long)dst_len * 1000000 >> 10,
+				 (u32)us));
+	setenv_hex("filesize", dst_len);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	unzip,	6,	1,	do_unzip,
+	"decompress a memory region and time it",
+	"[-r] srcaddr dstaddr [dstsize [srcsize]]\n"
+	"    - decompress the gzip, lzop, lz4 or bzip2 data at srcaddr to\n"
+	"      dstaddr and print the time taken. srcsize is needed for lz4\n"
+	"      data in the legacy format, which has no end mark.\n"
+	"      -r uses the reference bzip2 decoder"
+);
@@ -105,6 +105,36 @@ void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob)
 	}
 }
 
+#ifdef CONFIG_BOOTM_INPLACE
+/*
+ * Check whether the fdt can be used where it is, and if so reserve it.
+ * It has to be within the bootmap, or below fdt_high if that is set,
+ * with room after it for the padding. image_setup_libfdt() later grows
+ * the tree to the end of its 4K page plus FDT_RAMDISK_OVERHEAD, so check
+ * for that much.
+ */
+static int boot_fdt_in_place(struct lmb *lmb, void *fdt_blob, ulong of_len,
+			     const char *fdt_high)
+{
+	ulong limit = getenv_bootm_mapsize() + getenv_bootm_low();
+	ulong start = (ulong)fdt_blob;
+	ulong len;
+
+	if (fdt_high) {
+		limit = simple_strtoul(fdt_high, NULL, 16);
+		if (!limit)
+			limit = ~0UL;
+	}
+
+	len = ALIGN(start + of_len, 0x1000) + FDT_RAMDISK_OVERHEAD - start;
+	if (!boot_in_place_ok(lmb, start, len, 8, limit))
+		return 0;
+
+	lmb_reserve(lmb, start, len);
+	return 1;
+}
+#endif
+
 /**
  * boot_relocate_fdt - relocate flat device tree
  * @lmb: pointer to lmb handle, will be used for memory mgmt
@@ -114,7 +144,9 @@ void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob)
  * boot_relocate_fdt() allocates a region of memory within the bootmap and
  * relocates the of_flat_tree into that region, even if the fdt is already in
  * the bootmap.  It also expands the size of the fdt by CONFIG_SYS_FDT_PAD
- * bytes.
+ * bytes.  With CONFIG_BOOTM_INPLACE the fdt is left where it is when it
+ * is within the bootmap (or below fdt_high) and boot_in_place_ok() finds
+ * room for the padding after it.
  *
  * of_flat_tree and of_size are set to final (after relocation) values
  *
@@ -146,7 +178,12 @@ int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size)
 
 	/* If fdt_high is set use it to select the relocation address */
 	fdt_high = getenv("fdt_high");
-	if (fdt_high) {
+#ifdef CONFIG_BOOTM_INPLACE
+	disable_relocation = boot_fdt_in_place(lmb, fdt_blob, of_len, fdt_high);
+#endif
+	if (disable_relocation) {
+		of_start = fdt_blob;
+	} else if (fdt_high) {
 		void *desired_addr = (void *)simple_strtoul(fdt_high, NULL, 16);
 
 		if (((ulong) desired_addr) == ~0UL) {
@@ -198,7 +235,7 @@ int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size)
 			fdt_error("fdt move failed");
 			goto error;
 		}
-		puts("OK\n");
+		printf("OK, %lu bytes moved\n", (ulong)*of_size);
 	}
 
 	*of_flat_tree = of_start;
@@ -470,7 +507,15 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	ulong *initrd_end = &images->initrd_end;
 	int ret;
 
+	/*
+	 * Index the tree for the fixups below, they look up many nodes,
+	 * and batch their property edits into one rewrite of the tree.
+	 */
+	fdt_index_build(blob);
+	fdt_txn_begin(blob);
 	if (fdt_chosen(blob, 1) < 0) {
+		fdt_txn_commit(blob);
+		fdt_index_clear();
 		puts("ERROR: /chosen node create failed");
 		puts(" - must RESET the board to recover.\n");
 		return -1;
@@ -479,6 +524,12 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	if (IMAAGE_OF_BOARD_SETUP)
 		ft_board_setup(blob, gd->bd);
 	fdt_fixup_ethernet(blob);
+	ret = fdt_txn_commit(blob);
+	fdt_index_clear();
+	if (ret < 0) {
+		printf("ERROR: fixups failed: %s\n", fdt_strerror(ret));
+		return ret;
+	}
 
 	/* Delete the old LMB reservation */
 	lmb_free(lmb, (phys_addr_t)(u32)(uintptr_t)blob,
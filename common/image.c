@@ -160,6 +160,7 @@ static const table_entry_t uimage_comp[] = {
 	{	IH_COMP_GZIP,	"gzip",		"gzip compressed",	},
 	{	IH_COMP_LZMA,	"lzma",		"lzma compressed",	},
 	{	IH_COMP_LZO,	"lzo",		"lzo compressed",	},
+	{	IH_COMP_LZ4,	"lz4",		"lz4 compressed",	},
 	{	-1,		"",		"",			},
 };
 
@@ -963,6 +964,46 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 	return 0;
 }
 
+#if defined(CONFIG_LMB) && defined(CONFIG_BOOTM_INPLACE)
+#ifndef CONFIG_SYS_BOOTM_KERNEL_FOOTPRINT
+#define CONFIG_SYS_BOOTM_KERNEL_FOOTPRINT	0
+#endif
+
+/**
+ * boot_in_place_ok - check whether an image can be used where it is
+ * @lmb: pointer to lmb handle
+ * @start: image start address
+ * @len: image length, including any room it needs to grow
+ * @align: required alignment of start
+ * @limit: the image must end at or below this address, ~0 for no limit
+ *
+ * An image can stay where it was loaded when it lies in memory handed
+ * to the OS, overlaps nothing reserved so far (U-Boot, the stack, the
+ * kernel, fdt memreserve regions, an image placed earlier), and does
+ * not lie in the CONFIG_SYS_BOOTM_KERNEL_FOOTPRINT bytes above bootm_low
+ * that the kernel may decompress itself to.
+ *
+ * returns:
+ *     1 - the image can be used in place
+ *     0 - it has to be copied
+ */
+int boot_in_place_ok(struct lmb *lmb, ulong start, ulong len, ulong align,
+		     ulong limit)
+{
+	ulong low = getenv_bootm_low();
+
+	if (start & (align - 1))
+		return 0;
+	if (start + len < start || (limit != ~0UL && start + len > limit))
+		return 0;
+	if (start < low + CONFIG_SYS_BOOTM_KERNEL_FOOTPRINT &&
+	    start + len > low)
+		return 0;
+
+	return lmb_is_free(lmb, start, len);
+}
+#endif
+
 #ifdef CONFIG_SYS_BOOT_RAMDISK_HIGH
 /**
  * boot_ramdisk_high - relocate init ramdisk
@@ -976,6 +1017,8 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
  *
  * boot_ramdisk_high() takes a relocation hint from "initrd_high" environement
  * variable and if requested ramdisk data is moved to a specified location.
+ * With CONFIG_BOOTM_INPLACE the ramdisk is only moved if it cannot be
+ * used where it is, see boot_in_place_ok().
  *
  * Initrd_start and initrd_end are set to final (after relocation) ramdisk
  * start/end addresses if ramdisk image start and len were provided,
@@ -1013,6 +1056,16 @@ int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 	debug("## initrd_high = 0x%08lx, copy_to_ram = %d\n",
 			initrd_high, initrd_copy_to_ram);
 
+#ifdef CONFIG_BOOTM_INPLACE
+	if (rd_data && initrd_copy_to_ram &&
+	    boot_in_place_ok(lmb, rd_data, rd_len, 0x1000,
+			     initrd_high ? initrd_high : ~0UL)) {
+		printf("   Using Ramdisk in place at %08lx, end %08lx\n",
+		       rd_data, rd_data + rd_len);
+		initrd_copy_to_ram = 0;
+	}
+#endif
+
 	if (rd_data) {
 		if (!initrd_copy_to_ram) {	/* zero-copy ramdisk support */
 			debug("   in-place initrd\n");
@@ -1048,7 +1101,7 @@ int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 			 */
 			flush_cache((unsigned long)*initrd_start, rd_len);
 #endif
-			puts("OK\n");
+			printf("OK, %lu bytes moved\n", rd_len);
 		}
 	} else {
 		*initrd_start = 0;
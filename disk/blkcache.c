@@ -0,0 +1,260 @@
+/*
+ * Block read cache shared by the filesystems
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * The FAT, ext4 and ZFS code read metadata (FAT sectors, directories,
+ * inode tables, extent nodes, uberblocks) a few blocks at a time and
+ * often read the same blocks again. A driver's block_read method hands
+ * such small requests to blkcache_read(), which keeps the most recently
+ * used data in lines of line_blocks aligned blocks. A miss reads all the
+ * missing lines the request covers with one call of the driver, plus a
+ * readahead window that grows while the misses are sequential. Requests
+ * larger than the readahead buffer, such as a kernel image, go straight
+ * to the driver and do not displace the cached metadata.
+ *
+ * Writes go to the device and the cached copies are updated, so the
+ * cache never holds data the device does not have.
+ */
+
+#include <common.h>
+#include <blkcache.h>
+#include <malloc.h>
+#include <linux/list.h>
+
+#ifndef CONFIG_BLKCACHE_LINES
+#define CONFIG_BLKCACHE_LINES		64
+#endif
+#ifndef CONFIG_BLKCACHE_LINE_BLOCKS
+#define CONFIG_BLKCACHE_LINE_BLOCKS	8
+#endif
+#define BLKCACHE_RA_MAX			8	/* lines per device read */
+
+struct blkcache_line {
+	struct list_head lru;
+	block_dev_desc_t *dev;		/* NULL if the line is unused */
+	lbaint_t start;			/* a multiple of line_blocks */
+	u8 *data;
+};
+
+static struct {
+	struct list_head lru;		/* most recently used first */
+	struct blkcache_line *lines;
+	u8 *data;			/* line data, then rabuf */
+	u8 *rabuf;			/* device reads go here */
+	unsigned int nlines;
+	unsigned int line_blocks;
+	unsigned long blksz;		/* 0 until the lines are allocated */
+	block_dev_desc_t *ra_dev;	/* where the last miss ended */
+	lbaint_t ra_next;
+	unsigned int ra_lines;		/* current readahead window */
+	struct blkcache_stats stats;
+} cache = {
+	.nlines = CONFIG_BLKCACHE_LINES,
+	.line_blocks = CONFIG_BLKCACHE_LINE_BLOCKS,
+};
+
+static void blkcache_free(void)
+{
+	free(cache.lines);
+	free(cache.data);
+	cache.lines = NULL;
+	cache.data = NULL;
+	cache.rabuf = NULL;
+	cache.blksz = 0;
+	cache.ra_dev = NULL;
+}
+
+static int blkcache_alloc(unsigned long blksz)
+{
+	unsigned long line_size = cache.line_blocks * blksz;
+	unsigned int i;
+
+	cache.lines = calloc(cache.nlines, sizeof(*cache.lines));
+	cache.data = memalign(ARCH_DMA_MINALIGN,
+			      (cache.nlines + BLKCACHE_RA_MAX) * line_size);
+	if (!cache.lines || !cache.data) {
+		printf("blkcache: no memory for %u lines of %lu bytes\n",
+		       cache.nlines, line_size);
+		blkcache_free();
+		cache.nlines = 0;
+		return -1;
+	}
+
+	INIT_LIST_HEAD(&cache.lru);
+	for (i = 0; i < cache.nlines; i++) {
+		cache.lines[i].data = cache.data + i * line_size;
+		list_add_tail(&cache.lines[i].lru, &cache.lru);
+	}
+	cache.rabuf = cache.data + cache.nlines * line_size;
+	cache.blksz = blksz;
+
+	return 0;
+}
+
+static struct blkcache_line *blkcache_find(block_dev_desc_t *dev,
+					   lbaint_t start)
+{
+	struct blkcache_line *line;
+
+	list_for_each_entry(line, &cache.lru, lru)
+		if (line->dev == dev && line->start == start)
+			return line;
+
+	return NULL;
+}
+
+/*
+ * Read the line at lstart, which is not cached, and the uncached lines
+ * after it up to end and the readahead window, with one call of bread.
+ */
+static int blkcache_fill(block_dev_desc_t *dev, lbaint_t lstart,
+			 lbaint_t end, blkcache_bread_t bread)
+{
+	unsigned int lb = cache.line_blocks, need, want, count, i;
+	struct blkcache_line *line;
+	lbaint_t nblk;
+
+	if (dev == cache.ra_dev && lstart == cache.ra_next)
+		cache.ra_lines = cache.ra_lines ?
+			min(2 * cache.ra_lines, BLKCACHE_RA_MAX) : 1;
+	else
+		cache.ra_lines = 0;
+
+	/* leave at least half of the lines to the rest of the cache */
+	need = DIV_ROUND_UP(end - lstart, lb);
+	want = min(need + cache.ra_lines,
+		   min(BLKCACHE_RA_MAX, max(cache.nlines / 2, 1U)));
+	for (count = 1; count < want; count++)
+		if (lstart + count * lb >= dev->lba ||
+		    blkcache_find(dev, lstart + count * lb))
+			break;
+
+	nblk = min((lbaint_t)count * lb, dev->lba - lstart);
+	if (bread(dev->dev, lstart, nblk, cache.rabuf) != nblk)
+		return -1;
+	cache.stats.reads++;
+	cache.stats.misses += count;
+	if (count > need)
+		cache.stats.ahead += count - need;
+
+	for (i = 0; i < count; i++) {
+		line = list_entry(cache.lru.prev, struct blkcache_line, lru);
+		line->dev = dev;
+		line->start = lstart + i * lb;
+		memcpy(line->data, cache.rabuf + i * lb * cache.blksz,
+		       lb * cache.blksz);
+		list_move(&line->lru, &cache.lru);
+	}
+	cache.ra_dev = dev;
+	cache.ra_next = lstart + count * lb;
+
+	return 0;
+}
+
+unsigned long blkcache_read(block_dev_desc_t *dev, unsigned long start,
+			    lbaint_t blkcnt, void *buffer,
+			    blkcache_bread_t bread)
+{
+	unsigned int lb = cache.line_blocks;
+	lbaint_t blk = start, end = start + blkcnt, lstart, off, n;
+	struct blkcache_line *line;
+	u8 *dst = buffer;
+
+	if (cache.nlines && !cache.blksz)
+		blkcache_alloc(dev->blksz);
+
+	if (!cache.nlines || dev->blksz != cache.blksz || !blkcnt ||
+	    blkcnt > BLKCACHE_RA_MAX * lb || end > dev->lba) {
+		cache.stats.bypass++;
+		return bread(dev->dev, start, blkcnt, buffer);
+	}
+
+	while (blk < end) {
+		off = blk % lb;
+		lstart = blk - off;
+		n = min(lb - off, end - blk);
+
+		line = blkcache_find(dev, lstart);
+		if (line) {
+			cache.stats.hits++;
+		} else {
+			if (blkcache_fill(dev, lstart, end, bread))
+				return 0;
+			line = blkcache_find(dev, lstart);
+		}
+		list_move(&line->lru, &cache.lru);
+
+		memcpy(dst, line->data + off * cache.blksz, n * cache.blksz);
+		dst += n * cache.blksz;
+		blk += n;
+	}
+
+	return blkcnt;
+}
+
+void blkcache_write(block_dev_desc_t *dev, unsigned long start,
+		    lbaint_t blkcnt, const void *buffer)
+{
+	lbaint_t end = start + blkcnt, from, to;
+	struct blkcache_line *line;
+
+	if (!cache.blksz)
+		return;
+
+	list_for_each_entry(line, &cache.lru, lru) {
+		if (line->dev != dev || line->start >= end ||
+		    line->start + cache.line_blocks <= start)
+			continue;
+		from = max((lbaint_t)start, line->start);
+		to = min(end, line->start + cache.line_blocks);
+		memcpy(line->data + (from - line->start) * cache.blksz,
+		       buffer + (from - start) * cache.blksz,
+		       (to - from) * cache.blksz);
+	}
+}
+
+void blkcache_invalidate(block_dev_desc_t *dev)
+{
+	struct blkcache_line *line, *next;
+
+	if (!cache.blksz)
+		return;
+
+	/* to the end of the LRU list, so that they are reused first */
+	list_for_each_entry_safe(line, next, &cache.lru, lru) {
+		if (line->dev && (!dev || line->dev == dev)) {
+			line->dev = NULL;
+			list_move_tail(&line->lru, &cache.lru);
+		}
+	}
+	cache.ra_dev = NULL;
+}
+
+int blkcache_configure(unsigned int lines, unsigned int line_blocks)
+{
+	if (!line_blocks || line_blocks > 128)
+		return -1;
+
+	blkcache_free();
+	cache.nlines = lines;
+	cache.line_blocks = line_blocks;
+
+	return 0;
+}
+
+void blkcache_get_stats(struct blkcache_stats *stats, unsigned int *lines,
+			unsigned int *line_blocks)
+{
+	*stats = cache.stats;
+	*lines = cache.nlines;
+	*line_blocks = cache.line_blocks;
+}
+
+void blkcache_clear_stats(void)
+{
+	memset(&cache.stats, 0, sizeof(cache.stats));
+}
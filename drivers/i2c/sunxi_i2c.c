@@ -182,29 +182,21 @@ static int i2c_start(int status)
 	return 0;
 }
 
-int i2c_do_read(uchar chip, uint addr, int alen, uchar *buffer, int len)
+static int i2c_send_buf(uchar *buffer, int len)
 {
-	u32 status;
-	u32 ctl;
-
-	if (i2c_start(TWI_STAT_TX_STA) != 0)
-		return -1;
-
-	/* Send chip address */
-	if (i2c_send_data(chip << 1 | 0, TWI_STAT_TX_AW_ACK) != 0)
-		return -1;
-
-	/* Send data address */
-	if (i2c_send_data(addr, TWI_STAT_TXD_ACK) != 0)
-		return -1;
+	while (len > 0) {
+		if (i2c_send_data(*buffer++, TWI_STAT_TXD_ACK) != 0)
+			return -1;
+		len--;
+	}
 
-	/* Send restart for read */
-	if (i2c_start(TWI_STAT_TX_RESTA) != 0)
-		return -1;
+	return 0;
+}
 
-	/* Send chip address */
-	if (i2c_send_data(chip << 1 | 1, TWI_STAT_TX_AR_ACK) != 0)
-		return -1;
+static int i2c_recv_buf(uchar *buffer, int len)
+{
+	u32 status;
+	u32 ctl;
 
 	/* Set ACK mode */
 	ctl = readl(&i2c_base->ctl);
@@ -233,6 +225,57 @@ int i2c_do_read(uchar chip, uint addr, int alen, uchar *buffer, int len)
 	return 0;
 }
 
+static int i2c_do_write_read(uchar chip, uchar *wbuf, int wlen,
+			     uchar *rbuf, int rlen)
+{
+	if (i2c_start(TWI_STAT_TX_STA) != 0)
+		return -1;
+
+	/* Send chip address */
+	if (i2c_send_data(chip << 1 | 0, TWI_STAT_TX_AW_ACK) != 0)
+		return -1;
+
+	/* Send register address and any payload in one go */
+	if (i2c_send_buf(wbuf, wlen) != 0)
+		return -1;
+
+	if (rlen <= 0)
+		return 0;
+
+	/* Send restart for read */
+	if (i2c_start(TWI_STAT_TX_RESTA) != 0)
+		return -1;
+
+	/* Send chip address */
+	if (i2c_send_data(chip << 1 | 1, TWI_STAT_TX_AR_ACK) != 0)
+		return -1;
+
+	return i2c_recv_buf(rbuf, rlen);
+}
+
+/*
+ * Combined transfer: write wlen bytes from wbuf, then issue a repeated
+ * start and read rlen bytes into rbuf, all within a single bus
+ * transaction. Either half may carry multiple bytes, which lets register
+ * type devices be read or written in bursts without the start/address/
+ * stop overhead of one i2c_read()/i2c_write() call per register.
+ */
+int i2c_write_read(uchar chip, uchar *wbuf, int wlen, uchar *rbuf, int rlen)
+{
+	int rc = i2c_do_write_read(chip, wbuf, wlen, rbuf, rlen);
+
+	i2c_stop();
+
+	return rc;
+}
+
+int i2c_do_read(uchar chip, uint addr, int alen, uchar *buffer, int len)
+{
+	uchar reg = addr;
+
+	return i2c_do_write_read(chip, &reg, 1, buffer, len);
+}
+
 int i2c_read(uchar chip, uint addr, int alen, uchar *buffer, int len)
 {
 	int rc = i2c_do_read(chip, addr, alen, buffer, len);
@@ -257,13 +300,7 @@ static int i2c_do_write(uchar chip, uint addr, int alen, uchar *buffer,
 		return -1;
 
 	/* Send data */
-	while (len > 0) {
-		if (i2c_send_data(*buffer++, TWI_STAT_TXD_ACK) != 0)
-			return -1;
-		len--;
-	}
-
-	return 0;
+	return i2c_send_buf(buffer, len);
 }
 
 int i2c_write(uchar chip, uint addr, int alen, uchar *buffer, int len)
@@ -27,6 +27,9 @@
 #include <common.h>
 #include <command.h>
 #include <mmc.h>
+#include <blkcache.h>
+#include <fs.h>
+#include <perf.h>
 #include <part.h>
 #include <malloc.h>
 #include <linux/list.h>
@@ -177,12 +180,47 @@ static int mmc_send_status(struct mmc *mmc, int timeout)
 static int mmc_set_blocklen(struct mmc *mmc, int len)
 {
 	struct mmc_cmd cmd;
+	int err;
+
+	/*
+	 * The card keeps the block length until it is reinitialised, and
+	 * in DDR mode it is fixed at 512 bytes and CMD16 is illegal.
+	 */
+	if (mmc->blocklen == len || mmc->ddr_mode)
+		return 0;
 
 	cmd.cmdidx = MMC_CMD_SET_BLOCKLEN;
 	cmd.resp_type = MMC_RSP_R1;
 	cmd.cmdarg = len;
 
-	return mmc_send_cmd(mmc, &cmd, NULL);
+	err = mmc_send_cmd(mmc, &cmd, NULL);
+	mmc->blocklen = err ? 0 : len;
+
+	return err;
+}
+
+/*
+ * Announce the length of a multiple block transfer with CMD23, so that
+ * it ends without CMD12. Returns 1 if the count was set.
+ */
+static int mmc_set_block_count(struct mmc *mmc, lbaint_t blkcnt)
+{
+	struct mmc_cmd cmd;
+
+	if (blkcnt < 2 || !(mmc->card_caps & MMC_MODE_CMD23))
+		return 0;
+
+	cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.cmdarg = blkcnt & 0xffff;
+
+	if (mmc_send_cmd(mmc, &cmd, NULL)) {
+		/* do without it from now on */
+		mmc->card_caps &= ~MMC_MODE_CMD23;
+		return 0;
+	}
+
+	return 1;
 }
 
 struct mmc *find_mmc_device(int dev_num)
@@ -264,6 +302,9 @@ mmc_berase(int dev_num, unsigned long start, lbaint_t blkcnt)
 	if (!mmc)
 		return -1;
 
+	fs_invalidate(&mmc->block_dev);
+	blkcache_invalidate(&mmc->block_dev);
+
 	if ((start % mmc->erase_grp_size) || (blkcnt % mmc->erase_grp_size))
 		printf("\n\nCaution! Your devices Erase group is 0x%x\n"
 			"The erase range would be change to 0x%lx~0x%lx\n\n",
@@ -294,6 +335,7 @@ mmc_write_blocks(struct mmc *mmc, ulong start, lbaint_t blkcnt, const void*src)
 	struct mmc_cmd cmd;
 	struct mmc_data data;
 	int timeout = 1000;
+	int sbc;
 
 	if ((start + blkcnt) > mmc->block_dev.lba) {
 		printf("MMC: block number 0x%lx exceeds max(0x%lx)\n",
@@ -303,7 +345,10 @@ mmc_write_blocks(struct mmc *mmc, ulong start, lbaint_t blkcnt, const void*src)
 
 	if (blkcnt == 0)
 		return 0;
-	else if (blkcnt == 1)
+
+	sbc = !mmc_host_is_spi(mmc) && mmc_set_block_count(mmc, blkcnt);
+
+	if (blkcnt == 1)
 		cmd.cmdidx = MMC_CMD_WRITE_SINGLE_BLOCK;
 	else
 		cmd.cmdidx = MMC_CMD_WRITE_MULTIPLE_BLOCK;
@@ -318,7 +363,7 @@ mmc_write_blocks(struct mmc *mmc, ulong start, lbaint_t blkcnt, const void*src)
 	data.src = src;
 	data.blocks = blkcnt;
 	data.blocksize = mmc->write_bl_len;
-	data.flags = MMC_DATA_WRITE;
+	data.flags = MMC_DATA_WRITE | (sbc ? MMC_DATA_SBC : 0);
 
 	if (mmc_send_cmd(mmc, &cmd, &data)) {
 		printf("mmc write failed\n");
@@ -328,7 +373,7 @@ mmc_write_blocks(struct mmc *mmc, ulong start, lbaint_t blkcnt, const void*src)
 	/* SPI multiblock writes terminate using a special
 	 * token, not a STOP_TRANSMISSION request.
 	 */
-	if (!mmc_host_is_spi(mmc) && blkcnt > 1) {
+	if (!mmc_host_is_spi(mmc) && blkcnt > 1 && !sbc) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -349,6 +394,8 @@ static ulong
 mmc_bwrite(int dev_num, ulong start, lbaint_t blkcnt, const void*src)
 {
 	lbaint_t cur, blocks_todo = blkcnt;
+	ulong blk = start;
+	const void *buf = src;
 
 	struct mmc *mmc = find_mmc_device(dev_num);
 	if (!mmc)
@@ -357,15 +404,22 @@ mmc_bwrite(int dev_num, ulong start, lbaint_t blkcnt, const void*src)
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
+	/* a mounted filesystem may have cached what is overwritten here */
+	fs_invalidate(&mmc->block_dev);
+
 	do {
 		cur = (blocks_todo > mmc->b_max) ?  mmc->b_max : blocks_todo;
-		if(mmc_write_blocks(mmc, start, cur, src) != cur)
+		if(mmc_write_blocks(mmc, blk, cur, buf) != cur) {
+			blkcache_invalidate(&mmc->block_dev);
 			return 0;
+		}
 		blocks_todo -= cur;
-		start += cur;
-		src += cur * mmc->write_bl_len;
+		blk += cur;
+		buf += cur * mmc->write_bl_len;
 	} while (blocks_todo > 0);
 
+	blkcache_write(&mmc->block_dev, start, blkcnt, src);
+
 	return blkcnt;
 }
 
@@ -374,6 +428,7 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, ulong start,
 {
 	struct mmc_cmd cmd;
 	struct mmc_data data;
+	int sbc = mmc_set_block_count(mmc, blkcnt);
 
 	if (blkcnt > 1)
 		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
@@ -390,12 +445,12 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, ulong start,
 	data.dest = dst;
 	data.blocks = blkcnt;
 	data.blocksize = mmc->read_bl_len;
-	data.flags = MMC_DATA_READ;
+	data.flags = MMC_DATA_READ | (sbc ? MMC_DATA_SBC : 0);
 
 	if (mmc_send_cmd(mmc, &cmd, &data))
 		return 0;
 
-	if (blkcnt > 1) {
+	if (blkcnt > 1 && !sbc) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -408,7 +463,8 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, ulong start,
 	return blkcnt;
 }
 
-static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
+static ulong mmc_bread_blocks(int dev_num, ulong start, lbaint_t blkcnt,
+			      void *dst)
 {
 	lbaint_t cur, blocks_todo = blkcnt;
 
@@ -440,6 +496,22 @@ static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
 	return blkcnt;
 }
 
+static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
+{
+	struct mmc *mmc = find_mmc_device(dev_num);
+	ulong ret;
+
+	if (!mmc)
+		return 0;
+
+	perf_start(PERF_MMC_BREAD);
+	ret = blkcache_read(&mmc->block_dev, start, blkcnt, dst,
+			    mmc_bread_blocks);
+	perf_stop(PERF_MMC_BREAD);
+
+	return ret;
+}
+
 static int mmc_go_idle(struct mmc *mmc)
 {
 	struct mmc_cmd cmd;
@@ -667,6 +739,10 @@ static int mmc_change_freq(struct mmc *mmc)
 	if (mmc_host_is_spi(mmc))
 		return 0;
 
+	/* CMD23 is mandatory from version 3.1 on */
+	if (mmc->version >= MMC_VERSION_3)
+		mmc->card_caps |= MMC_MODE_CMD23;
+
 	/* Only version 4 supports high-speed */
 	if (mmc->version < MMC_VERSION_4)
 		return 0;
@@ -699,6 +775,10 @@ static int mmc_change_freq(struct mmc *mmc)
 	else
 		mmc->card_caps |= MMC_MODE_HS;
 
+	/* the I/O voltage is 3.3V, DDR at 1.2V is of no use */
+	if (cardtype & EXT_CSD_CARD_TYPE_DDR_1_8V)
+		mmc->card_caps |= MMC_MODE_DDR_52MHz;
+
 	return 0;
 }
 
@@ -744,6 +824,13 @@ int mmc_switch_part(int dev_num, unsigned int part_num)
 	if (ret)
 		return ret;
 
+	/*
+	 * Same block device, other contents: forget the mounts and cached
+	 * blocks of the old partition
+	 */
+	fs_invalidate(&mmc->block_dev);
+	blkcache_invalidate(&mmc->block_dev);
+
 	return mmc_set_capacity(mmc, part_num);
 }
 
@@ -852,6 +939,9 @@ retry_scr:
 	if (mmc->scr[0] & SD_DATA_4BIT)
 		mmc->card_caps |= MMC_MODE_4BIT;
 
+	if (mmc->scr[0] & SD_CMD23_SUPPORT)
+		mmc->card_caps |= MMC_MODE_CMD23;
+
 	/* Version 1.0 doesn't support switching */
 	if (mmc->version == SD_VERSION_1_0)
 		return 0;
@@ -1213,42 +1303,52 @@ static int mmc_startup(struct mmc *mmc)
 	} else {
 		int idx;
 
-		/* An array of possible bus widths in order of preference */
-		static unsigned ext_csd_bits[] = {
-			EXT_CSD_BUS_WIDTH_8,
-			EXT_CSD_BUS_WIDTH_4,
-			EXT_CSD_BUS_WIDTH_1,
-		};
-
-		/* An array to map CSD bus widths to host cap bits */
-		static unsigned ext_to_hostcaps[] = {
-			[EXT_CSD_BUS_WIDTH_4] = MMC_MODE_4BIT,
-			[EXT_CSD_BUS_WIDTH_8] = MMC_MODE_8BIT,
+		/*
+		 * Bus modes in order of preference and the host and card
+		 * capabilities they need. Each is checked at full speed by
+		 * reading EXT_CSD again, and the next one is tried if the
+		 * switch fails or the data differs.
+		 */
+		static const struct {
+			u8 ext_csd_bits;
+			u8 width;
+			uint caps;
+		} modes[] = {
+			{ EXT_CSD_DDR_BUS_WIDTH_8, 8,
+			  MMC_MODE_8BIT | MMC_MODE_DDR_52MHz },
+			{ EXT_CSD_DDR_BUS_WIDTH_4, 4,
+			  MMC_MODE_4BIT | MMC_MODE_DDR_52MHz },
+			{ EXT_CSD_BUS_WIDTH_8, 8, MMC_MODE_8BIT },
+			{ EXT_CSD_BUS_WIDTH_4, 4, MMC_MODE_4BIT },
+			{ EXT_CSD_BUS_WIDTH_1, 1, 0 },
 		};
 
-		/* An array to map chosen bus width to an integer */
-		static unsigned widths[] = {
-			8, 4, 1,
-		};
+		if (mmc->card_caps & MMC_MODE_HS) {
+			if (mmc->card_caps & MMC_MODE_HS_52MHz)
+				mmc->tran_speed = 52000000;
+			else
+				mmc->tran_speed = 26000000;
+		}
 
-		for (idx=0; idx < ARRAY_SIZE(ext_csd_bits); idx++) {
-			unsigned int extw = ext_csd_bits[idx];
+		for (idx = 0; idx < ARRAY_SIZE(modes); idx++) {
+			uint caps = modes[idx].caps;
 
-			/*
-			 * Check to make sure the controller supports
-			 * this bus width, if it's more than 1
-			 */
-			if (extw != EXT_CSD_BUS_WIDTH_1 &&
-					!(mmc->host_caps & ext_to_hostcaps[extw]))
+			/* the card has no width bits, only the DDR one */
+			if ((mmc->host_caps & caps) != caps ||
+			    ((caps & MMC_MODE_DDR_52MHz) &&
+			     !(mmc->card_caps & MMC_MODE_DDR_52MHz)))
 				continue;
 
 			err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL,
-					EXT_CSD_BUS_WIDTH, extw);
+					EXT_CSD_BUS_WIDTH,
+					modes[idx].ext_csd_bits);
 
 			if (err)
 				continue;
 
-			mmc_set_bus_width(mmc, widths[idx]);
+			mmc->ddr_mode = !!(caps & MMC_MODE_DDR_52MHz);
+			mmc->bus_width = modes[idx].width;
+			mmc_set_clock(mmc, mmc->tran_speed);
 
 			err = mmc_send_ext_csd(mmc, test_csd);
 			if (!err && ext_csd[EXT_CSD_PARTITIONING_SUPPORT] \
@@ -1262,17 +1362,18 @@ static int mmc_startup(struct mmc *mmc)
 				 && memcmp(&ext_csd[EXT_CSD_SEC_CNT], \
 					&test_csd[EXT_CSD_SEC_CNT], 4) == 0) {
 
-				mmc->card_caps |= ext_to_hostcaps[extw];
+				mmc->card_caps &= ~MMC_MODE_DDR_52MHz;
+				mmc->card_caps |= caps;
 				break;
 			}
-		}
 
-		if (mmc->card_caps & MMC_MODE_HS) {
-			if (mmc->card_caps & MMC_MODE_HS_52MHz)
-				mmc->tran_speed = 52000000;
-			else
-				mmc->tran_speed = 26000000;
+			debug("%s: %d bit%s mode failed, falling back\n",
+			      mmc->name, modes[idx].width,
+			      mmc->ddr_mode ? " DDR" : "");
+			mmc->ddr_mode = 0;
 		}
+		if (idx == ARRAY_SIZE(modes))
+			mmc->card_caps &= ~MMC_MODE_DDR_52MHz;
 	}
 
 	mmc_set_clock(mmc, mmc->tran_speed);
@@ -1365,6 +1466,12 @@ int mmc_start_init(struct mmc *mmc)
 	if (mmc->has_init)
 		return 0;
 
+	/* this may be a different card, drop what was read from it */
+	fs_invalidate(&mmc->block_dev);
+	blkcache_invalidate(&mmc->block_dev);
+	mmc->blocklen = 0;
+	mmc->ddr_mode = 0;
+
 	err = mmc->init(mmc);
 
 	if (err)
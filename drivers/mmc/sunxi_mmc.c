@@ -108,6 +108,8 @@ struct sunxi_mmc_des {
 struct sunxi_mmc_host {
 	unsigned mmc_no;
 	uint32_t *mclkreg;
+	unsigned mclk;		/* mclkreg value, written with the clock off */
+	unsigned sdr_mclk;	/* the same for the SDR modes */
 	unsigned database;
 	unsigned fatal_err;
 	unsigned mod_clk;
@@ -201,9 +203,16 @@ static int mmc_clk_io_on(int sdc_no)
 	case 2:
 		/* CMD-PC6, CLK-PC7, D0-PC8, D1-PC9, D2-PC10, D3-PC11 */
 		writel(0x33 << 24, &gpio_c->cfg[0]);
+#ifdef CONFIG_MMC2_8BIT
+		/* D4-PC12, D5-PC13, D6-PC14, D7-PC15 */
+		writel(0x33333333, &gpio_c->cfg[1]);
+		writel(0x55555 << 12, &gpio_c->pull[0]);
+		writel(0xaaaaa << 12, &gpio_c->drv[0]);
+#else
 		writel(0x3333, &gpio_c->cfg[1]);
 		writel(0x555 << 12, &gpio_c->pull[0]);
 		writel(0xaaa << 12, &gpio_c->drv[0]);
+#endif
 		break;
 
 	case 3:
@@ -229,7 +238,9 @@ static int mmc_clk_io_on(int sdc_no)
 		divider = 4;
 	else
 		divider = 3;
-	writel((0x1 << 31) | (0x2 << 24) | divider, mmchost->mclkreg);
+	mmchost->sdr_mclk = (0x1 << 31) | (0x2 << 24) | divider;
+	mmchost->mclk = mmchost->sdr_mclk;
+	writel(mmchost->mclk, mmchost->mclkreg);
 	mmchost->mod_clk = pll5_clk / (divider + 1);
 
 	dumphex32("ccmu", (char *)SUNXI_CCM_BASE, 0x100);
@@ -273,6 +284,9 @@ static int mmc_config_clock(struct mmc *mmc, unsigned div)
 	if (mmc_update_clk(mmc))
 		return -1;
 
+	/* Switch the module clock while the card clock is off */
+	writel(mmchost->mclk, mmchost->mclkreg);
+
 	/* Change Divider Factor */
 	rval &= ~(0xff);
 	rval |= div;
@@ -289,16 +303,70 @@ static int mmc_config_clock(struct mmc *mmc, unsigned div)
 	return 0;
 }
 
+/*
+ * Module clock register value for DDR52: the module clock runs at the
+ * card clock for 4 data lines and at twice it, divided by 2 in the
+ * controller, for 8. The output and sample clocks are delayed by a
+ * number of PLL5 periods, from the phases Linux uses for this controller.
+ */
+static unsigned mmc_ddr_mclk(struct mmc *mmc, unsigned *clkdiv)
+{
+	struct sunxi_mmc_host *mmchost = (struct sunxi_mmc_host *)mmc->priv;
+	unsigned pll5_clk = clock_get_pll5();
+	unsigned rate = mmc->clock, out_deg = 60, sample_deg = 120;
+	unsigned div, step, out, sample;
+
+	*clkdiv = 0;
+	if (mmc->bus_width == 8) {
+		rate *= 2;
+		*clkdiv = 1;
+		out_deg = 90;
+		sample_deg = 180;
+	}
+
+	div = DIV_ROUND_UP(pll5_clk, rate);
+	if (div > 16)
+		div = 16;
+	mmchost->mod_clk = pll5_clk / div;
+
+	/* degrees of the module clock per PLL5 period */
+	step = 360 / div;
+	out = min((out_deg + step / 2) / step, 7U);
+	sample = min((sample_deg + step / 2) / step, 7U);
+
+	return (0x1 << 31) | (0x2 << 24) | (sample << 20) | (out << 8) |
+	       (div - 1);
+}
+
 static void mmc_set_ios(struct mmc *mmc)
 {
 	struct sunxi_mmc_host *mmchost = (struct sunxi_mmc_host *)mmc->priv;
 	unsigned int clkdiv = 0;
+	unsigned int rval;
 
-	debug("set ios: bus_width: %x, clock: %d, mod_clk: %d\n",
-	      mmc->bus_width, mmc->clock, mmchost->mod_clk);
+	debug("set ios: bus_width: %x, clock: %d, ddr: %d, mod_clk: %d\n",
+	      mmc->bus_width, mmc->clock, mmc->ddr_mode, mmchost->mod_clk);
+
+	/*
+	 * GCTRL[10] : DDR mode
+	 */
+	rval = readl(&mmchost->reg->gctrl) & ~(0x1 << 10);
+	if (mmc->ddr_mode)
+		rval |= 0x1 << 10;
+	writel(rval, &mmchost->reg->gctrl);
 
 	/* Change clock first */
-	clkdiv = (mmchost->mod_clk + (mmc->clock >> 1)) / mmc->clock / 2;
+	if (mmc->ddr_mode && mmc->clock) {
+		mmchost->mclk = mmc_ddr_mclk(mmc, &clkdiv);
+	} else {
+		if (mmchost->mclk != mmchost->sdr_mclk) {
+			mmchost->mclk = mmchost->sdr_mclk;
+			mmchost->mod_clk = clock_get_pll5() /
+					   ((mmchost->mclk & 0xf) + 1);
+		}
+		clkdiv = (mmchost->mod_clk + (mmc->clock >> 1)) /
+			 mmc->clock / 2;
+	}
 	if (mmc->clock)
 		if (mmc_config_clock(mmc, clkdiv)) {
 			mmchost->fatal_err = 1;
@@ -502,7 +570,8 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 		cmdval |= (0x1 << 9) | (0x1 << 13);
 		if (data->flags & MMC_DATA_WRITE)
 			cmdval |= (0x1 << 10);
-		if (data->blocks > 1)
+		/* with the count set by CMD23 the card stops by itself */
+		if (data->blocks > 1 && !(data->flags & MMC_DATA_SBC))
 			cmdval |= (0x1 << 12);
 		writel(data->blocksize, &mmchost->reg->blksz);
 		writel(data->blocks * data->blocksize, &mmchost->reg->bytecnt);
@@ -568,7 +637,7 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 				debug("data timeout %x\n", error);
 				goto out;
 			}
-			if (data->blocks > 1)
+			if (cmdval & (0x1 << 12))
 				done = status & (0x1 << 14);
 			else
 				done = status & (0x1 << 3);
@@ -619,6 +688,9 @@ out:
 	}
 	if (error) {
 		writel(0x7, &mmchost->reg->gctrl);
+		if (mmc->ddr_mode)
+			writel(readl(&mmchost->reg->gctrl) | (0x1 << 10),
+			       &mmchost->reg->gctrl);
 		mmc_update_clk(mmc);
 		debug("mmc cmd %d err 0x%08x\n", cmd->cmdidx, error);
 	}
@@ -648,6 +720,12 @@ int sunxi_mmc_init(int sdc_no)
 	mmc->voltages = MMC_VDD_32_33 | MMC_VDD_33_34;
 	mmc->host_caps = MMC_MODE_4BIT;
 	mmc->host_caps |= MMC_MODE_HS_52MHz | MMC_MODE_HS;
+	mmc->host_caps |= MMC_MODE_CMD23;
+	mmc->host_caps |= MMC_MODE_DDR_52MHz;
+#ifdef CONFIG_MMC2_8BIT
+	if (sdc_no == 2)
+		mmc->host_caps |= MMC_MODE_8BIT;
+#endif
 
 	mmc->f_min = 400000;
 	mmc->f_max = 52000000;
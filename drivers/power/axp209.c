@@ -24,6 +24,7 @@
 #include <common.h>
 #include <i2c.h>
 #include <axp209.h>
+#include <asm/arch/i2c.h>
 
 enum axp209_reg {
 	AXP209_CHIP_VERSION = 0x3,
@@ -34,14 +35,84 @@ enum axp209_reg {
 	AXP209_SHUTDOWN = 0x32,
 };
 
+#define AXP209_I2C_ADDR		0x34
+
+/*
+ * Shadow copy of the voltage/output control register window. Rails are
+ * configured with read-modify-write sequences, often on registers shared
+ * between several outputs (LDO2/LDO4), so keeping a local copy saves the
+ * reads. Registers outside the window are volatile (status, IRQ, ADC)
+ * and always go to the chip.
+ *
+ * This is used from SPL before DRAM is up, hence the .data placement.
+ */
+#define AXP209_CACHE_FIRST	0x10
+#define AXP209_CACHE_LAST	0x3f
+#define AXP209_CACHE_SIZE	(AXP209_CACHE_LAST - AXP209_CACHE_FIRST + 1)
+
+static struct {
+	u8 val[AXP209_CACHE_SIZE];
+	u8 valid[AXP209_CACHE_SIZE];
+} axp209_cache __attribute__ ((section(".data")));
+
+static int axp209_cached(enum axp209_reg reg)
+{
+	return reg >= AXP209_CACHE_FIRST && reg <= AXP209_CACHE_LAST;
+}
+
 int axp209_write(enum axp209_reg reg, u8 val)
 {
-	return i2c_write(0x34, reg, 1, &val, 1);
+	int rc = i2c_write(AXP209_I2C_ADDR, reg, 1, &val, 1);
+
+	if (rc == 0 && axp209_cached(reg)) {
+		reg -= AXP209_CACHE_FIRST;
+		axp209_cache.val[reg] = val;
+		axp209_cache.valid[reg] = 1;
+	}
+
+	return rc;
 }
 
 int axp209_read(enum axp209_reg reg, u8 *val)
 {
-	return i2c_read(0x34, reg, 1, val, 1);
+	int rc;
+
+	if (!axp209_cached(reg))
+		return i2c_read(AXP209_I2C_ADDR, reg, 1, val, 1);
+
+	reg -= AXP209_CACHE_FIRST;
+	if (!axp209_cache.valid[reg]) {
+		rc = i2c_read(AXP209_I2C_ADDR, reg + AXP209_CACHE_FIRST, 1,
+			      &axp209_cache.val[reg], 1);
+		if (rc)
+			return rc;
+		axp209_cache.valid[reg] = 1;
+	}
+
+	*val = axp209_cache.val[reg];
+
+	return 0;
+}
+
+/*
+ * Fill the whole shadow window with a single auto-incrementing burst read.
+ */
+int axp209_cache_sync(void)
+{
+	u8 reg = AXP209_CACHE_FIRST;
+	u8 buf[AXP209_CACHE_SIZE];
+	int rc, i;
+
+	rc = i2c_write_read(AXP209_I2C_ADDR, &reg, 1, buf, sizeof(buf));
+	if (rc)
+		return rc;
+
+	for (i = 0; i < AXP209_CACHE_SIZE; i++) {
+		axp209_cache.val[i] = buf[i];
+		axp209_cache.valid[i] = 1;
+	}
+
+	return 0;
 }
 
 int axp209_set_dcdc2(int mvolt)
@@ -74,18 +145,13 @@ int axp209_set_dcdc2(int mvolt)
 int axp209_set_dcdc3(int mvolt)
 {
 	int cfg = (mvolt - 700) / 25;
-	u8 reg;
-	int rc;
 
 	if (cfg < 0)
 		cfg = 0;
 	if (cfg > (1 << 7) - 1)
 		cfg = (1 << 7) - 1;
 
-	rc = axp209_write(AXP209_DCDC3_VOLTAGE, cfg);
-	rc |= axp209_read(AXP209_DCDC3_VOLTAGE, &reg);
-
-	return rc;
+	return axp209_write(AXP209_DCDC3_VOLTAGE, cfg);
 }
 
 int axp209_set_ldo2(int mvolt)
@@ -104,11 +170,8 @@ int axp209_set_ldo2(int mvolt)
 		return rc;
 
 	reg = (reg & 0x0f) | (cfg << 4);
-	rc = axp209_write(AXP209_LDO24_VOLTAGE, reg);
-	if (rc)
-		return rc;
 
-	return 0;
+	return axp209_write(AXP209_LDO24_VOLTAGE, reg);
 }
 
 int axp209_set_ldo3(int mvolt)
@@ -144,11 +207,8 @@ int axp209_set_ldo4(int mvolt)
 
 	/* LDO4 configuration is in lower 4 bits */
 	reg = (reg & 0xf0) | (cfg << 0);
-	rc = axp209_write(AXP209_LDO24_VOLTAGE, reg);
-	if (rc)
-		return rc;
 
-	return 0;
+	return axp209_write(AXP209_LDO24_VOLTAGE, reg);
 }
 
 void axp209_poweroff(void)
@@ -175,6 +235,10 @@ int axp209_init(void)
 	if (rc)
 		return rc;
 
+	rc = axp209_cache_sync();
+	if (rc)
+		return rc;
+
 	/* Seems there is some unexpected variance in this register.
 	 * blindly assume it is the correct chip for now
 	 * 0x21 and 0x41 have been observed.
@@ -53,6 +53,9 @@ int ext4fs_indir2_blkno = -1;
 uint32_t *ext4fs_indir3_block;
 int ext4fs_indir3_size;
 int ext4fs_indir3_blkno = -1;
+/* group descriptor block last read by ext4fs_blockgroup() */
+static char *ext4fs_gd_block;
+static long int ext4fs_gd_blkno = -1;
 struct ext2_inode *g_parent_inode;
 static int symlinknest;
 
@@ -1470,9 +1473,25 @@ static int ext4fs_blockgroup
 	debug("ext4fs read %d group descriptor (blkno %ld blkoff %u)\n",
 	      group, blkno, blkoff);
 
-	return ext4fs_devread(blkno << (LOG2_BLOCK_SIZE(data) - log2blksz),
-			      blkoff, sizeof(struct ext2_block_group),
-			      (char *)blkgrp);
+	/*
+	 * Every inode lookup needs a descriptor, and the descriptors of
+	 * a small filesystem share one block, so keep the block around.
+	 */
+	if (blkno != ext4fs_gd_blkno) {
+		if (ext4fs_gd_block == NULL) {
+			ext4fs_gd_block = malloc(EXT2_BLOCK_SIZE(data));
+			if (ext4fs_gd_block == NULL)
+				return 0;
+		}
+		ext4fs_gd_blkno = -1;
+		if (!ext4fs_devread(blkno << (LOG2_BLOCK_SIZE(data) - log2blksz),
+				    0, EXT2_BLOCK_SIZE(data), ext4fs_gd_block))
+			return 0;
+		ext4fs_gd_blkno = blkno;
+	}
+	memcpy(blkgrp, ext4fs_gd_block + blkoff, sizeof(*blkgrp));
+
+	return 1;
 }
 
 int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
@@ -1877,6 +1896,11 @@ void ext4fs_close(void)
 		ext4fs_indir3_size = 0;
 		ext4fs_indir3_blkno = -1;
 	}
+	if (ext4fs_gd_block != NULL) {
+		free(ext4fs_gd_block);
+		ext4fs_gd_block = NULL;
+		ext4fs_gd_blkno = -1;
+	}
 }
 
 int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
@@ -2171,7 +2195,11 @@ int ext4fs_open(const char *filename)
 	if (ext4fs_root == NULL)
 		return -1;
 
-	ext4fs_file = NULL;
+	/* the filesystem stays mounted between files */
+	if (ext4fs_file != NULL) {
+		ext4fs_free_node(ext4fs_file, &ext4fs_root->diropen);
+		ext4fs_file = NULL;
+	}
 	status = ext4fs_find_file(filename, &ext4fs_root->diropen, &fdiro,
 				  FILETYPE_REG);
 	if (status == 0)
@@ -2198,6 +2226,12 @@ int ext4fs_mount(unsigned part_length)
 	struct ext2_data *data;
 	int status;
 	struct ext_filesystem *fs = get_fs();
+
+	/* the cached descriptor block may belong to another filesystem */
+	free(ext4fs_gd_block);
+	ext4fs_gd_block = NULL;
+	ext4fs_gd_blkno = -1;
+
 	data = zalloc(SUPERBLOCK_SIZE);
 	if (!data)
 		return 0;
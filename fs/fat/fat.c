@@ -55,6 +55,23 @@ static void downcase(char *str)
 static block_dev_desc_t *cur_dev;
 static disk_partition_t cur_part_info;
 
+/*
+ * Geometry and FAT buffer of the volume on cur_dev, set up by the first
+ * read after fat_set_blk_dev() and kept until the next one or fat_close().
+ */
+static struct {
+	int valid;
+	fsdata data;
+	__u32 root_cluster;
+	int rootdir_size;
+} fat_mnt;
+
+static void fat_umount(void)
+{
+	free(fat_mnt.data.fatbuf);
+	memset(&fat_mnt, 0, sizeof(fat_mnt));
+}
+
 #define DOS_BOOT_MAGIC_OFFSET	0x1fe
 #define DOS_FS_TYPE_OFFSET	0x36
 #define DOS_FS32_TYPE_OFFSET	0x52
@@ -72,6 +89,7 @@ int fat_set_blk_dev(block_dev_desc_t *dev_desc, disk_partition_t *info)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, buffer, dev_desc->blksz);
 
+	fat_umount();
 	cur_dev = dev_desc;
 	cur_part_info = *info;
 
@@ -819,29 +837,15 @@ exit:
 	return ret;
 }
 
-__u8 do_fat_read_at_block[MAX_CLUSTSIZE]
-	__aligned(ARCH_DMA_MINALIGN);
-
-long
-do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
-	       unsigned long maxsize, int dols)
+/* Read the boot sector of the volume on cur_dev unless already done */
+static int fat_mount(void)
 {
-	char fnamecopy[2048];
 	boot_sector bs;
 	volume_info volinfo;
-	fsdata datablock;
-	fsdata *mydata = &datablock;
-	dir_entry *dentptr = NULL;
-	__u16 prevcksum = 0xffff;
-	char *subname = "";
-	__u32 cursect;
-	int idx, isdir = 0;
-	int files = 0, dirs = 0;
-	long ret = -1;
-	int firsttime;
-	__u32 root_cluster = 0;
-	int rootdir_size = 0;
-	int j;
+	fsdata *mydata = &fat_mnt.data;
+
+	if (fat_mnt.valid)
+		return 0;
 
 	if (read_bootsectandvi(&bs, &volinfo, &mydata->fatsize)) {
 		debug("Error: reading boot sector\n");
@@ -849,7 +853,7 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 	}
 
 	if (mydata->fatsize == 32) {
-		root_cluster = bs.root_cluster;
+		fat_mnt.root_cluster = bs.root_cluster;
 		mydata->fatlength = bs.fat32_length;
 	} else {
 		mydata->fatlength = bs.fat_length;
@@ -857,8 +861,7 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 
 	mydata->fat_sect = bs.reserved;
 
-	cursect = mydata->rootdir_sect
-		= mydata->fat_sect + mydata->fatlength * bs.fats;
+	mydata->rootdir_sect = mydata->fat_sect + mydata->fatlength * bs.fats;
 
 	mydata->sect_size = (bs.sector_size[1] << 8) + bs.sector_size[0];
 	mydata->clust_size = bs.cluster_size;
@@ -872,12 +875,12 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 		mydata->data_begin = mydata->rootdir_sect -
 					(mydata->clust_size * 2);
 	} else {
-		rootdir_size = ((bs.dir_entries[1]  * (int)256 +
+		fat_mnt.rootdir_size = ((bs.dir_entries[1]  * (int)256 +
 				 bs.dir_entries[0]) *
 				 sizeof(dir_entry)) /
 				 mydata->sect_size;
 		mydata->data_begin = mydata->rootdir_sect +
-					rootdir_size -
+					fat_mnt.rootdir_size -
 					(mydata->clust_size * 2);
 	}
 
@@ -895,12 +898,45 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 	       mydata->fatsize, mydata->fat_sect, mydata->fatlength);
 	debug("Rootdir begins at cluster: %d, sector: %d, offset: %x\n"
 	       "Data begins at: %d\n",
-	       root_cluster,
+	       fat_mnt.root_cluster,
 	       mydata->rootdir_sect,
 	       mydata->rootdir_sect * mydata->sect_size, mydata->data_begin);
 	debug("Sector size: %d, cluster size: %d\n", mydata->sect_size,
 	      mydata->clust_size);
 
+	fat_mnt.valid = 1;
+	return 0;
+}
+
+__u8 do_fat_read_at_block[MAX_CLUSTSIZE]
+	__aligned(ARCH_DMA_MINALIGN);
+
+long
+do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
+	       unsigned long maxsize, int dols)
+{
+	char fnamecopy[2048];
+	fsdata *mydata;
+	dir_entry *dentptr = NULL;
+	__u16 prevcksum = 0xffff;
+	char *subname = "";
+	__u32 cursect;
+	int idx, isdir = 0;
+	int files = 0, dirs = 0;
+	long ret = -1;
+	int firsttime;
+	__u32 root_cluster;
+	int rootdir_size;
+	int j;
+
+	if (fat_mount())
+		return -1;
+
+	mydata = &fat_mnt.data;
+	root_cluster = fat_mnt.root_cluster;
+	rootdir_size = fat_mnt.rootdir_size;
+	cursect = mydata->rootdir_sect;
+
 	/* "cwd" is always the root... */
 	while (ISDIRDELIM(*filename))
 		filename++;
@@ -1172,7 +1208,6 @@ rootdir_done:
 	debug("Size: %d, got: %ld\n", FAT2CPU32(dentptr->size), ret);
 
 exit:
-	free(mydata->fatbuf);
 	return ret;
 }
 
@@ -1276,4 +1311,5 @@ int fat_read_file(const char *filename, void *buf, int offset, int len)
 
 void fat_close(void)
 {
+	fat_umount();
 }
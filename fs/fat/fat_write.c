@@ -110,6 +110,9 @@ static void set_name(dir_entry *dirent, const char *filename)
 }
 
 static __u8 num_of_fats;
+/* the FAT buffer has entries not written to the device yet */
+static int fatbuf_dirty;
+
 /*
  * Write fat buffer into block device
  */
@@ -120,6 +123,9 @@ static int flush_fat_buffer(fsdata *mydata)
 	__u8 *bufptr = mydata->fatbuf;
 	__u32 startblock = mydata->fatbufnum * FATBUFBLOCKS;
 
+	if (!fatbuf_dirty)
+		return 0;
+
 	startblock += mydata->fat_sect;
 
 	if (getsize > fatlength)
@@ -139,6 +145,7 @@ static int flush_fat_buffer(fsdata *mydata)
 			return -1;
 		}
 	}
+	fatbuf_dirty = 0;
 
 	return 0;
 }
@@ -467,6 +474,153 @@ get_long_file_name(fsdata *mydata, int curclust, __u8 *cluster,
 	return 0;
 }
 
+/*
+ * Free cluster bitmap
+ *
+ * Looking for free clusters through get_fatent_value() reads the FAT a
+ * buffer of FATBUFBLOCKS sectors at a time, from the start for every new
+ * cluster chain. Instead, chunks of FAT_FREE_CHUNK sectors are read once,
+ * when the allocator first needs them, and their free clusters noted in
+ * a bitmap that set_fatent_value() keeps up to date. Without memory for
+ * the bitmap the FAT is searched entry by entry as before.
+ */
+#define FAT_FREE_CHUNK		64	/* sectors */
+
+static struct {
+	__u32 *map;		/* bit set: cluster is free */
+	__u8 *scanned;		/* chunks already read into the map */
+	__u8 *chunk;		/* buffer for reading a chunk */
+	__u32 nclust;		/* FAT entries in use, data clusters + 2 */
+	__u32 per_chunk;	/* FAT entries per chunk */
+} fat_free;
+
+static void fat_free_release(void)
+{
+	free(fat_free.map);
+	free(fat_free.scanned);
+	free(fat_free.chunk);
+	memset(&fat_free, 0, sizeof(fat_free));
+}
+
+static void fat_free_init(fsdata *mydata)
+{
+	__u32 nchunks, nclust;
+
+	fat_free_release();
+
+	/*
+	 * Data clusters are numbered from 2, after the two reserved entries
+	 * (data_begin is where cluster 0 would start), so the bitmap and the
+	 * bound cover the count of data clusters plus 2.
+	 */
+	nclust = (total_sector - mydata->data_begin - 2 * mydata->clust_size) /
+		 mydata->clust_size + 2;
+	if (nclust > mydata->fatlength * mydata->sect_size * 8 /
+		     mydata->fatsize)
+		nclust = mydata->fatlength * mydata->sect_size * 8 /
+			 mydata->fatsize;
+	fat_free.nclust = nclust;
+	fat_free.per_chunk = FAT_FREE_CHUNK * mydata->sect_size * 8 /
+			     mydata->fatsize;
+	nchunks = DIV_ROUND_UP(fat_free.nclust, fat_free.per_chunk);
+
+	fat_free.map = calloc(DIV_ROUND_UP(fat_free.nclust, 32),
+			      sizeof(__u32));
+	fat_free.scanned = calloc(nchunks, 1);
+	fat_free.chunk = memalign(ARCH_DMA_MINALIGN,
+				  FAT_FREE_CHUNK * mydata->sect_size);
+	if (!fat_free.map || !fat_free.scanned || !fat_free.chunk) {
+		debug("FAT: no memory for the free cluster bitmap\n");
+		fat_free_release();
+		fat_free.nclust = nclust;
+	}
+}
+
+/* Note that a cluster became free or used, if its chunk has been read */
+static void fat_free_set(__u32 clust, int is_free)
+{
+	if (!fat_free.map || clust >= fat_free.nclust ||
+	    !fat_free.scanned[clust / fat_free.per_chunk])
+		return;
+
+	if (is_free)
+		fat_free.map[clust / 32] |= 1U << (clust % 32);
+	else
+		fat_free.map[clust / 32] &= ~(1U << (clust % 32));
+}
+
+static int flush_fat_buffer(fsdata *mydata);
+
+/* Read chunk n of the FAT and note its free clusters */
+static int fat_free_scan(fsdata *mydata, __u32 n)
+{
+	__u32 first = n * fat_free.per_chunk;
+	__u32 sect = n * FAT_FREE_CHUNK;
+	__u32 count = FAT_FREE_CHUNK, i, val;
+
+	/* the device must have the entries changed in the FAT buffer */
+	if (flush_fat_buffer(mydata) < 0)
+		return -1;
+
+	if (count > mydata->fatlength - sect)
+		count = mydata->fatlength - sect;
+	if (disk_read(mydata->fat_sect + sect, count, fat_free.chunk) < 0) {
+		debug("Error reading FAT blocks\n");
+		return -1;
+	}
+
+	for (i = 0; i < fat_free.per_chunk && first + i < fat_free.nclust;
+	     i++) {
+		if (mydata->fatsize == 32)
+			val = FAT2CPU32(((__u32 *)fat_free.chunk)[i]) &
+			      0x0fffffff;
+		else
+			val = FAT2CPU16(((__u16 *)fat_free.chunk)[i]);
+		if (!val)
+			fat_free.map[(first + i) / 32] |=
+				1U << ((first + i) % 32);
+	}
+	fat_free.scanned[n] = 1;
+
+	return 0;
+}
+
+static __u32 get_fatent_value(fsdata *mydata, __u32 entry);
+
+/* Check whether cluster clust is free */
+static int fat_cluster_free(fsdata *mydata, __u32 clust)
+{
+	if (clust >= fat_free.nclust)
+		return 0;
+	if (!fat_free.map)
+		return get_fatent_value(mydata, clust) == 0;
+
+	if (!fat_free.scanned[clust / fat_free.per_chunk] &&
+	    fat_free_scan(mydata, clust / fat_free.per_chunk) < 0)
+		return 0;
+
+	return (fat_free.map[clust / 32] >> (clust % 32)) & 1;
+}
+
+/* Find the first free cluster from clust on, 0 if there is none */
+static __u32 fat_find_free(fsdata *mydata, __u32 clust)
+{
+	while (clust < fat_free.nclust) {
+		/* skip words of the bitmap without a free cluster */
+		if (fat_free.map && !(clust % 32) &&
+		    fat_free.scanned[clust / fat_free.per_chunk] &&
+		    !fat_free.map[clust / 32]) {
+			clust += 32;
+			continue;
+		}
+		if (fat_cluster_free(mydata, clust))
+			return clust;
+		clust++;
+	}
+
+	return 0;
+}
+
 /*
  * Set the entry at index 'entry' in a FAT (16/32) table.
  */
@@ -524,31 +678,12 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 	default:
 		return -1;
 	}
+	fatbuf_dirty = 1;
+	fat_free_set(entry, entry_value == 0);
 
 	return 0;
 }
 
-/*
- * Determine the entry value at index 'entry' in a FAT (16/32) table
- */
-static __u32 determine_fatent(fsdata *mydata, __u32 entry)
-{
-	__u32 next_fat, next_entry = entry + 1;
-
-	while (1) {
-		next_fat = get_fatent_value(mydata, next_entry);
-		if (next_fat == 0) {
-			set_fatent_value(mydata, entry, next_entry);
-			break;
-		}
-		next_entry++;
-	}
-	debug("FAT%d: entry: %08x, entry_value: %04x\n",
-	       mydata->fatsize, entry, next_entry);
-
-	return next_entry;
-}
-
 /*
  * Write at most 'size' bytes from 'buffer' into the specified cluster.
  * Return 0 on success, -1 otherwise.
@@ -592,20 +727,13 @@ set_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer,
 }
 
 /*
- * Find the first empty cluster
+ * Find the first empty cluster, -1 if the filesystem is full
  */
 static int find_empty_cluster(fsdata *mydata)
 {
-	__u32 fat_val, entry = 3;
+	__u32 entry = fat_find_free(mydata, 3);
 
-	while (1) {
-		fat_val = get_fatent_value(mydata, entry);
-		if (fat_val == 0)
-			break;
-		entry++;
-	}
-
-	return entry;
+	return entry ? entry : -1;
 }
 
 /*
@@ -622,6 +750,10 @@ static void flush_dir_table(fsdata *mydata, dir_entry **dentptr)
 		return;
 	}
 	dir_newclust = find_empty_cluster(mydata);
+	if (dir_newclust < 0) {
+		printf("error: no free cluster for the directory\n");
+		return;
+	}
 	set_fatent_value(mydata, dir_curclust, dir_newclust);
 	if (mydata->fatsize == 32)
 		set_fatent_value(mydata, dir_newclust, 0xffffff8);
@@ -630,9 +762,6 @@ static void flush_dir_table(fsdata *mydata, dir_entry **dentptr)
 
 	dir_curclust = dir_newclust;
 
-	if (flush_fat_buffer(mydata) < 0)
-		return;
-
 	memset(get_dentfromdir_block, 0x00,
 		mydata->clust_size * mydata->sect_size);
 
@@ -659,17 +788,14 @@ static int clear_fatent(fsdata *mydata, __u32 entry)
 		entry = fat_val;
 	}
 
-	/* Flush fat buffer */
-	if (flush_fat_buffer(mydata) < 0)
-		return -1;
-
 	return 0;
 }
 
 /*
  * Write at most 'maxsize' bytes from 'buffer' into
- * the file associated with 'dentptr'
- * Return the number of bytes read or -1 on fatal errors.
+ * the file associated with 'dentptr', whose start cluster must be free.
+ * Each run of free clusters is written with a single set_cluster().
+ * Return the number of bytes written or -1 on fatal errors.
  */
 static int
 set_contents(fsdata *mydata, dir_entry *dentptr, __u8 *buffer,
@@ -678,7 +804,7 @@ set_contents(fsdata *mydata, dir_entry *dentptr, __u8 *buffer,
 	unsigned long filesize = FAT2CPU32(dentptr->size), gotsize = 0;
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
-	__u32 endclust = 0, newclust = 0;
+	__u32 endclust, clust, eoc;
 	unsigned long actsize;
 
 	debug("Filesize: %ld bytes\n", filesize);
@@ -688,69 +814,42 @@ set_contents(fsdata *mydata, dir_entry *dentptr, __u8 *buffer,
 
 	debug("%ld bytes\n", filesize);
 
-	actsize = bytesperclust;
-	endclust = curclust;
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = determine_fatent(mydata, endclust);
-
-			if ((newclust - 1) != endclust)
-				goto getit;
-
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				debug("Invalid FAT entry\n");
-				return gotsize;
-			}
-			endclust = newclust;
+	eoc = mydata->fatsize == 32 ? 0xfffffff : 0xffff;
+	while (1) {
+		/* take the free clusters following curclust */
+		endclust = curclust;
+		actsize = bytesperclust;
+		while (actsize < filesize &&
+		       fat_cluster_free(mydata, endclust + 1)) {
+			endclust++;
 			actsize += bytesperclust;
 		}
-		/* actsize >= file size */
-		actsize -= bytesperclust;
-		/* set remaining clusters */
-		if (set_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			debug("error: writing cluster\n");
-			return -1;
-		}
+		if (actsize > filesize)
+			actsize = filesize;
 
-		/* set remaining bytes */
-		gotsize += (int)actsize;
-		filesize -= actsize;
-		buffer += actsize;
-		actsize = filesize;
+		for (clust = curclust; clust < endclust; clust++)
+			set_fatent_value(mydata, clust, clust + 1);
+		set_fatent_value(mydata, endclust, eoc);
 
-		if (set_cluster(mydata, endclust, buffer, (int)actsize) != 0) {
+		if (set_cluster(mydata, curclust, buffer, actsize) != 0) {
 			debug("error: writing cluster\n");
 			return -1;
 		}
 		gotsize += actsize;
-
-		/* Mark end of file in FAT */
-		if (mydata->fatsize == 16)
-			newclust = 0xffff;
-		else if (mydata->fatsize == 32)
-			newclust = 0xfffffff;
-		set_fatent_value(mydata, endclust, newclust);
-
-		return gotsize;
-getit:
-		if (set_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			debug("error: writing cluster\n");
-			return -1;
-		}
-		gotsize += (int)actsize;
 		filesize -= actsize;
 		buffer += actsize;
-
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			debug("Invalid FAT entry\n");
+		if (!filesize)
 			return gotsize;
+
+		curclust = fat_find_free(mydata, endclust + 1);
+		if (!curclust)
+			curclust = fat_find_free(mydata, 3);
+		if (!curclust) {
+			printf("Error: filesystem full\n");
+			return -1;
 		}
-		actsize = bytesperclust;
-		curclust = endclust = newclust;
-	} while (1);
+		set_fatent_value(mydata, endclust, curclust);
+	}
 }
 
 /*
@@ -971,6 +1070,8 @@ static int do_fat_write(const char *filename, void *buffer,
 		debug("Error: allocating memory\n");
 		return -1;
 	}
+	fatbuf_dirty = 0;
+	fat_free_init(mydata);
 
 	if (disk_read(cursect,
 		(mydata->fatsize == 32) ?
@@ -1082,7 +1183,10 @@ static int do_fat_write(const char *filename, void *buffer,
 	}
 
 exit:
+	fat_free_release();
 	free(mydata->fatbuf);
+	/* the FAT buffer kept by fat_mount() may be stale now */
+	fat_umount();
 	return ret < 0 ? ret : write_size;
 }
 
@@ -29,6 +29,30 @@ static block_dev_desc_t *fs_dev_desc;
 static disk_partition_t fs_partition;
 static int fs_type = FS_TYPE_ANY;
 
+#ifdef CONFIG_FS_MOUNT_CACHE
+#define FS_MOUNT_CACHE_SIZE	4
+
+/*
+ * Partitions resolved by fs_set_blk_dev(), so that repeated commands on
+ * the same partition neither re-read the partition table nor re-probe
+ * the filesystem types. Only the filesystem of fs_mnt_active is mounted
+ * in its driver, which keeps its state (FAT geometry and FAT buffer,
+ * ext4 superblock, root inode and descriptor block) between commands.
+ */
+struct fs_mount {
+	char ifname[16];
+	char dev_part[32];
+	int type;
+	block_dev_desc_t *dev_desc;
+	disk_partition_t partition;
+	unsigned long used;	/* for replacing the least recently used */
+};
+
+static struct fs_mount fs_mnt[FS_MOUNT_CACHE_SIZE];
+static struct fs_mount *fs_mnt_active;
+static unsigned long fs_mnt_clock;
+#endif
+
 static inline int fs_probe_unsupported(block_dev_desc_t *fs_dev_desc,
 				      disk_partition_t *fs_partition)
 {
@@ -120,10 +144,112 @@ static struct fstype_info *fs_get_info(int fstype)
 	return info;
 }
 
+#ifdef CONFIG_FS_MOUNT_CACHE
+/* Unmount the current filesystem, keeping the resolved partitions */
+static void fs_mount_release(void)
+{
+	if (!fs_mnt_active)
+		return;
+
+	fs_get_info(fs_mnt_active->type)->close();
+	fs_mnt_active = NULL;
+	fs_type = FS_TYPE_ANY;
+}
+
+void fs_invalidate(block_dev_desc_t *dev_desc)
+{
+	int i;
+
+	fs_mount_release();
+	for (i = 0; i < FS_MOUNT_CACHE_SIZE; i++) {
+		if (!dev_desc || fs_mnt[i].dev_desc == dev_desc)
+			memset(&fs_mnt[i], 0, sizeof(fs_mnt[i]));
+	}
+}
+
+/* The bootdevice variable stands in for a missing dev:part, as in part.c */
+static const char *fs_mount_dev_part(const char *dev_part_str)
+{
+	if (!dev_part_str || !*dev_part_str || !strcmp(dev_part_str, "-"))
+		return getenv("bootdevice");
+
+	return dev_part_str;
+}
+
+static struct fs_mount *fs_mount_find(const char *ifname,
+				      const char *dev_part_str, int fstype)
+{
+	struct fs_mount *mnt;
+	int i;
+
+	dev_part_str = fs_mount_dev_part(dev_part_str);
+	if (!dev_part_str)
+		return NULL;
+
+	for (i = 0, mnt = fs_mnt; i < FS_MOUNT_CACHE_SIZE; i++, mnt++) {
+		if (mnt->used &&
+		    (fstype == FS_TYPE_ANY || fstype == mnt->type) &&
+		    !strcmp(mnt->ifname, ifname) &&
+		    !strcmp(mnt->dev_part, dev_part_str))
+			return mnt;
+	}
+
+	return NULL;
+}
+
+static void fs_mount_add(const char *ifname, const char *dev_part_str)
+{
+	struct fs_mount *mnt, *victim = fs_mnt;
+	int i;
+
+	dev_part_str = fs_mount_dev_part(dev_part_str);
+	if (!dev_part_str || strlen(ifname) >= sizeof(mnt->ifname) ||
+	    strlen(dev_part_str) >= sizeof(mnt->dev_part))
+		return;
+
+	for (i = 0, mnt = fs_mnt; i < FS_MOUNT_CACHE_SIZE; i++, mnt++) {
+		if (mnt->used < victim->used)
+			victim = mnt;
+	}
+
+	strcpy(victim->ifname, ifname);
+	strcpy(victim->dev_part, dev_part_str);
+	victim->type = fs_type;
+	victim->dev_desc = fs_dev_desc;
+	victim->partition = fs_partition;
+	victim->used = ++fs_mnt_clock;
+	fs_mnt_active = victim;
+}
+
+/* Make mnt the current filesystem, mounting it if it is not already */
+static int fs_mount_use(struct fs_mount *mnt)
+{
+	if (mnt != fs_mnt_active) {
+		fs_mount_release();
+		if (fs_get_info(mnt->type)->probe(mnt->dev_desc,
+						  &mnt->partition)) {
+			memset(mnt, 0, sizeof(*mnt));
+			return -1;
+		}
+		fs_mnt_active = mnt;
+	}
+
+	fs_dev_desc = mnt->dev_desc;
+	fs_partition = mnt->partition;
+	fs_type = mnt->type;
+	mnt->used = ++fs_mnt_clock;
+
+	return 0;
+}
+#endif
+
 int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 {
 	struct fstype_info *info;
 	int part, i;
+#ifdef CONFIG_FS_MOUNT_CACHE
+	struct fs_mount *mnt;
+#endif
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
 	static int relocated;
 
@@ -140,6 +266,15 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 	}
 #endif
 
+#ifdef CONFIG_FS_MOUNT_CACHE
+	mnt = fs_mount_find(ifname, dev_part_str, fstype);
+	if (mnt && !fs_mount_use(mnt))
+		return 0;
+
+	/* the probes below replace the state of the mounted filesystem */
+	fs_mount_release();
+#endif
+
 	part = get_device_and_partition(ifname, dev_part_str, &fs_dev_desc,
 					&fs_partition, 1);
 	if (part < 0)
@@ -152,6 +287,9 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 
 		if (!info->probe(fs_dev_desc, &fs_partition)) {
 			fs_type = info->fstype;
+#ifdef CONFIG_FS_MOUNT_CACHE
+			fs_mount_add(ifname, dev_part_str);
+#endif
 			return 0;
 		}
 	}
@@ -163,6 +301,11 @@ static void fs_close(void)
 {
 	struct fstype_info *info = fs_get_info(fs_type);
 
+#ifdef CONFIG_FS_MOUNT_CACHE
+	/* stay mounted for the next command */
+	if (fs_mnt_active)
+		return;
+#endif
 	info->close();
 
 	fs_type = FS_TYPE_ANY;
@@ -176,7 +319,6 @@ int fs_ls(const char *dirname)
 
 	ret = info->ls(dirname);
 
-	fs_type = FS_TYPE_ANY;
 	fs_close();
 
 	return ret;
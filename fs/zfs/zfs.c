@@ -195,7 +195,10 @@ static int
 zlib_decompress(void *s, void *d,
 				uint32_t slen, uint32_t dlen)
 {
-	if (zlib_decompress(s, d, slen, dlen) < 0)
+	unsigned long len = slen;
+
+	/* skip the 2 byte zlib header; the adler32 trailer is not checked */
+	if (zunzip(d, dlen, s, &len, 1, 2) < 0)
 		return ZFS_ERR_BAD_FS;
 	return ZFS_ERR_NONE;
 }
@@ -26,4 +26,7 @@ extern int axp209_set_ldo2(int mvolt);
 extern int axp209_set_ldo3(int mvolt);
 extern int axp209_set_ldo4(int mvolt);
 extern void axp209_poweroff(void);
+
+/* Fill the shadow copy of the PMIC control registers in one burst read */
+extern int axp209_cache_sync(void);
 extern int axp209_init(void);
@@ -0,0 +1,69 @@
+/*
+ * Block read cache shared by the filesystems
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef _BLKCACHE_H_
+#define _BLKCACHE_H_
+
+#include <part.h>
+
+/* the block_read method of a driver, used to fill the cache */
+typedef unsigned long (*blkcache_bread_t)(int dev, unsigned long start,
+					  lbaint_t blkcnt, void *buffer);
+
+struct blkcache_stats {
+	unsigned long hits;	/* cache lines found */
+	unsigned long misses;	/* cache lines read from the device */
+	unsigned long ahead;	/* of those, lines read ahead */
+	unsigned long reads;	/* device reads to fill the cache */
+	unsigned long bypass;	/* large requests passed to the device */
+};
+
+#ifdef CONFIG_BLKCACHE
+/*
+ * Read blkcnt blocks from dev into buffer, from the cache where possible
+ * and with bread otherwise. Returns the number of blocks read like a
+ * block_read method.
+ */
+unsigned long blkcache_read(block_dev_desc_t *dev, unsigned long start,
+			    lbaint_t blkcnt, void *buffer,
+			    blkcache_bread_t bread);
+
+/* Update the cached copies of blocks written to the device */
+void blkcache_write(block_dev_desc_t *dev, unsigned long start,
+		    lbaint_t blkcnt, const void *buffer);
+
+/* Drop the blocks cached for dev, or for all devices if dev is NULL */
+void blkcache_invalidate(block_dev_desc_t *dev);
+
+/* Change the geometry, freeing the cache; lines = 0 disables it */
+int blkcache_configure(unsigned int lines, unsigned int line_blocks);
+
+void blkcache_get_stats(struct blkcache_stats *stats, unsigned int *lines,
+			unsigned int *line_blocks);
+void blkcache_clear_stats(void);
+#else
+static inline unsigned long blkcache_read(block_dev_desc_t *dev,
+					  unsigned long start,
+					  lbaint_t blkcnt, void *buffer,
+					  blkcache_bread_t bread)
+{
+	return bread(dev->dev, start, blkcnt, buffer);
+}
+
+static inline void blkcache_write(block_dev_desc_t *dev, unsigned long start,
+				  lbaint_t blkcnt, const void *buffer)
+{
+}
+
+static inline void blkcache_invalidate(block_dev_desc_t *dev)
+{
+}
+#endif
+
+#endif /* _BLKCACHE_H_ */
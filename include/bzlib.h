@@ -266,6 +266,11 @@ BZ_EXTERN int BZ_API(BZ2_bzBuffToBuffDecompress) (
       int           verbosity
    );
 
+/*-- U-Boot: faster one-shot decoder for in-memory data, lib/bunzip2.c.
+     Same return codes as BZ2_bzBuffToBuffDecompress. --*/
+int bunzip2(void *dest, unsigned int *destLen, const void *source,
+	    unsigned int sourceLen);
+
 
 /*--
    Code contributed by Yoshioka Tsuneo
@@ -788,6 +788,14 @@ int	init_timebase (void);
 int gunzip(void *, int, unsigned char *, unsigned long *);
 int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 						int stoponerr, int offset);
+struct gunzip_ctx;
+struct gunzip_ctx *gunzip_ctx_alloc(void);
+void gunzip_ctx_free(struct gunzip_ctx *ctx);
+int gunzip_ctx(struct gunzip_ctx *ctx, void *dst, int dstlen,
+	       unsigned char *src, unsigned long *lenp);
+int zunzip_ctx(struct gunzip_ctx *ctx, void *dst, int dstlen,
+	       unsigned char *src, unsigned long *lenp,
+	       int stoponerr, int offset);
 
 /* lib/qsort.c */
 void qsort(void *base, size_t nmemb, size_t size,
@@ -797,6 +805,10 @@ int strcmp_compar(const void *, const void *);
 /* lib/time.c */
 void	udelay        (unsigned long);
 void mdelay(unsigned long);
+unsigned long long timer_get_us(void);
+unsigned long long timer_deadline_us(unsigned long usec);
+int timer_deadline_passed(unsigned long long deadline);
+void udelay_until(unsigned long long deadline);
 
 /* lib/uuid.c */
 void uuid_str_to_bin(const char *uuid, unsigned char *out);
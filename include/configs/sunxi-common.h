@@ -96,16 +96,36 @@
 #define CONFIG_SYS_MMC_ENV_DEV		CONFIG_MMC_SUNXI_SLOT
 #endif
 
+/* bzip2 compressed kernels, with the faster decoder of lib/bunzip2.c */
+#define CONFIG_BZIP2
+#define CONFIG_BZIP2_FAST
+
 /*
  * Size of malloc() pool
  * 1MB = 0x100000, 0x100000 = 1024 * 1024
+ * plus 4MB with bzip2: the decoder needs 4 bytes per block byte, 3.6MB
+ * for bzip2 -9. Without it the pool stays at 1MB.
  */
+#ifdef CONFIG_BZIP2
+#define CONFIG_SYS_MALLOC_LEN		(CONFIG_ENV_SIZE + (5 << 20))
+#else
 #define CONFIG_SYS_MALLOC_LEN		(CONFIG_ENV_SIZE + (1 << 20))
+#endif
 
 /* Flat Device Tree (FDT/DT) support */
 #define CONFIG_OF_LIBFDT
+#define CONFIG_OF_LIBFDT_INDEX
+#define CONFIG_OF_LIBFDT_TXN
 #define CONFIG_SYS_BOOTMAPSZ		(16 << 20)
 
+/*
+ * Leave the ramdisk and fdt where they were loaded when the kernel can
+ * use them there, keeping clear of the first 32MB of DRAM that the
+ * kernel decompresses itself to
+ */
+#define CONFIG_BOOTM_INPLACE
+#define CONFIG_SYS_BOOTM_KERNEL_FOOTPRINT	(32 << 20)
+
 /*
  * Miscellaneous configurable options
  */
@@ -121,6 +141,8 @@
 #define CONFIG_SYS_BARGSIZE		CONFIG_SYS_CBSIZE
 
 /* memtest works on */
+#define CONFIG_CMD_MEMTEST
+#define CONFIG_SYS_MEMTEST_BURST	/* mtest.f cached burst mode */
 #define CONFIG_SYS_MEMTEST_START	CONFIG_SYS_SDRAM_BASE
 #define CONFIG_SYS_MEMTEST_END		(CONFIG_SYS_SDRAM_BASE + (256 << 20))
 #define CONFIG_SYS_LOAD_ADDR		0x50000000 /* default load address */
@@ -130,6 +152,40 @@
 
 #define CONFIG_SYS_HZ			1000
 
+/*
+ * D-cache for U-Boot and its SRAM stack from the start of board_init_f,
+ * with the early page table in the 64KB just below U-Boot
+ */
+#ifndef CONFIG_SPL_BUILD
+#define CONFIG_SYS_EARLY_DCACHE
+#define CONFIG_SYS_EARLY_TLB_ADDR	(CONFIG_SYS_TEXT_BASE - 0x10000)
+/* copy and fix up U-Boot for relocation with the D-cache on */
+#define CONFIG_SYS_RELOC_DCACHE
+#endif
+
+/* 64 bit CPU cycle counter (get_cycles) from the ARMv7 PMU */
+#define CONFIG_ARMV7_PMU
+/* per-region cycle/cache miss profiling, see include/perf.h */
+#define CONFIG_CMD_PERF
+
+/* assembler string functions, memcpy is also used for the inflate match copies */
+#ifndef CONFIG_SPL_BUILD
+#define CONFIG_USE_ARCH_MEMCPY
+#define CONFIG_USE_ARCH_MEMSET
+#define CONFIG_USE_ARCH_MEMMOVE
+#define CONFIG_USE_ARCH_MEMCMP
+#define CONFIG_USE_ARCH_MEMCHR
+#endif
+/* membench command to check and time them */
+#define CONFIG_CMD_MEMBENCH
+/* inflate_fast() variant for ARMv7, see lib/zlib/inffast_armv7.c */
+#define CONFIG_ZLIB_INFFAST_ARMV7
+
+/* lzop and lz4 compressed kernels, unzip command to compare decompressors */
+#define CONFIG_LZO
+#define CONFIG_LZ4
+#define CONFIG_CMD_UNZIP
+
 /* valid baudrates */
 #define CONFIG_BAUDRATE			115200
 #define CONFIG_SYS_BAUDRATE_TABLE	{ 9600, 19200, 38400, 57600, 115200 }
@@ -264,6 +320,12 @@
 #define CONFIG_CMD_EXT2		/* with this we can access ext2 bootfs */
 #define CONFIG_CMD_EXT4		/* with this we can access ext4 bootfs */
 #define CONFIG_CMD_ZFS		/* with this we can access ZFS bootfs */
+#define CONFIG_CMD_FS_GENERIC	/* load/ls for any of the above */
+#ifndef CONFIG_SPL_BUILD
+#define CONFIG_FS_MOUNT_CACHE	/* stay mounted between load commands */
+#define CONFIG_BLKCACHE		/* cache filesystem metadata blocks */
+#define CONFIG_CMD_BLKCACHE
+#endif
 
 #define CONFIG_SPL_FRAMEWORK
 #define CONFIG_SPL_LIBCOMMON_SUPPORT
@@ -285,6 +347,17 @@
 
 /* 32KB offset */
 #define CONFIG_SYS_MMCSD_RAW_MODE_U_BOOT_SECTOR	64
+/* SPL (eGON header) at 8KB offset */
+#define CONFIG_SUNXI_SPL_MMC_SECTOR	16
+
+/*
+ * "spl export" prepares the kernel arguments for a Falcon mode SPL. The
+ * sunxi SPL cannot boot a kernel yet, it always loads U-Boot.
+ */
+#ifndef CONFIG_SPL_BUILD
+#define CONFIG_CMD_SPL			/* spl export */
+#endif
+
 /* SPL starts at offset 8KiB im MMC and has the size of 24KiB */
 #define CONFIG_SPL_PAD_TO		24576		/* decimal for 'dd' */
 
@@ -130,5 +130,32 @@ static inline int fdt_status_disabled_by_alias(void *fdt, const char* alias)
 	return fdt_set_status_by_alias(fdt, alias, FDT_STATUS_DISABLED, 0);
 }
 
+#ifdef CONFIG_OF_LIBFDT_INDEX
+/*
+ * Index the nodes of fdt by path, phandle and compatible string, so
+ * fdt_path_offset(), fdt_node_offset_by_phandle() and
+ * fdt_node_offset_by_compatible() need not scan the tree until
+ * fdt_index_clear(). Only one tree is indexed at a time.
+ */
+int fdt_index_build(const void *fdt);
+void fdt_index_clear(void);
+#else
+static inline int fdt_index_build(const void *fdt) { return 0; }
+static inline void fdt_index_clear(void) {}
+#endif
+
+#ifdef CONFIG_OF_LIBFDT_TXN
+/*
+ * Between fdt_txn_begin() and fdt_txn_commit(), fdt_setprop() and
+ * friends only record their edits, and the commit rewrites the tree
+ * once. Only one tree has a transaction open at a time.
+ */
+int fdt_txn_begin(void *fdt);
+int fdt_txn_commit(void *fdt);
+#else
+static inline int fdt_txn_begin(void *fdt) { return 0; }
+static inline int fdt_txn_commit(void *fdt) { return 0; }
+#endif
+
 #endif /* ifdef CONFIG_OF_LIBFDT */
 #endif /* ifndef __FDT_SUPPORT_H */
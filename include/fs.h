@@ -54,6 +54,20 @@ int fs_ls(const char *dirname);
  */
 int fs_read(const char *filename, ulong addr, int offset, int len);
 
+/*
+ * Forget the partitions and filesystems cached for block device dev_desc,
+ * or for all devices if dev_desc is NULL, and unmount the current
+ * filesystem. Called when the media changes and before a filesystem
+ * driver is used directly, bypassing fs_set_blk_dev().
+ */
+#ifdef CONFIG_FS_MOUNT_CACHE
+void fs_invalidate(block_dev_desc_t *dev_desc);
+#else
+static inline void fs_invalidate(block_dev_desc_t *dev_desc)
+{
+}
+#endif
+
 /*
  * Common implementation for various filesystem commands, optionally limited
  * to a specific filesystem type via the fstype parameter.
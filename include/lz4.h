@@ -0,0 +1,40 @@
+/*
+ * LZ4 decompression
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __LZ4_H
+#define __LZ4_H
+
+/**
+ * ulz4fn() - Decompress LZ4 data
+ *
+ * Decompresses one or more concatenated LZ4 frames, as written by the
+ * lz4 tool. Skippable frames are ignored and the legacy frame format
+ * (lz4 -l, used for Linux kernel images) is accepted as well. Block and
+ * content checksums are skipped, not verified.
+ *
+ * @src:	pointer to the compressed data
+ * @srcn:	length of the compressed data
+ * @dst:	pointer to the output buffer
+ * @dstn:	in: size of the output buffer, out: bytes decompressed
+ * @return 0 if OK, -EPROTONOSUPPORT for an unknown format or feature,
+ * -EINVAL for corrupt data, -ENOBUFS if the output buffer is too small
+ */
+int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
+
+#endif /* __LZ4_H */
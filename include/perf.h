@@ -0,0 +1,63 @@
+/*
+ * Lightweight per-region profiling on top of the CPU performance counters
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __PERF_H
+#define __PERF_H
+
+/*
+ * Instrumented code regions. Each region accumulates call count, CPU
+ * cycles, L1 data cache refills and mispredicted branches between
+ * perf_start() and perf_stop(). Counts are inclusive: a region called
+ * from within another one is counted in both. Add new regions here and
+ * give them a name in common/cmd_perf.c.
+ */
+enum perf_region {
+	PERF_MMC_BREAD,
+	PERF_GUNZIP,
+	PERF_CRC32,
+	PERF_SHA256,
+	PERF_NET_RECEIVE,
+	PERF_LZO,
+	PERF_LZ4,
+	PERF_BUNZIP2,
+
+	PERF_REGION_COUNT,
+};
+
+/* Raw counter snapshot, filled in by the architecture */
+struct perf_counters {
+	unsigned long long cycles;
+	unsigned int dcache_miss;
+	unsigned int branch_miss;
+};
+
+#if defined(CONFIG_CMD_PERF) && !defined(CONFIG_SPL_BUILD) && \
+	!defined(USE_HOSTCC)
+void perf_start(enum perf_region region);
+void perf_stop(enum perf_region region);
+
+/* Provided by the architecture (arch/arm/cpu/armv7/pmu.c) */
+void perf_counters_init(void);
+void perf_counters_read(struct perf_counters *pc);
+#else
+#define perf_start(region)	do { } while (0)
+#define perf_stop(region)	do { } while (0)
+#endif
+
+#endif /* __PERF_H */
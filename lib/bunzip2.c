@@ -0,0 +1,563 @@
+/*
+ * One-shot bzip2 decompression
+ *
+ * A faster alternative to BZ2_bzBuffToBuffDecompress() for data that is
+ * completely in memory, as for bootm:
+ *
+ *  - Huffman codes up to BUNZIP2_LOOKUP_BITS long are decoded with one
+ *    table lookup instead of bit by bit; longer ones fall back to the
+ *    canonical limit/base search
+ *  - the bit buffer is refilled four bytes at a time, and there is no
+ *    resumable state machine around every read
+ *  - the move-to-front list is shifted a word rather than a byte at a
+ *    time
+ *  - the inverse BWT walks tt[] entries holding both the symbol and the
+ *    link to the next one, so each output byte costs one load, and
+ *    writes straight to the output buffer; the block CRC is computed
+ *    over the output afterwards
+ *
+ * All state lives in a context allocated per call, so concurrent calls
+ * are safe. Concatenated streams, as written by pbzip2, are accepted.
+ *
+ * The bitstream format follows bzip2 1.0 by Julian Seward, see
+ * lib/bzlib_decompress.c.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <watchdog.h>
+#include <perf.h>
+#include <asm/unaligned.h>
+#include "bzlib_private.h"
+
+#define BUNZIP2_LOOKUP_BITS	10
+#define BUNZIP2_LOOKUP_SIZE	(1 << BUNZIP2_LOOKUP_BITS)
+#define BUNZIP2_MAX_CODE_LEN	20	/* longest code bzip2 produces */
+
+#define BUNZIP2_BLOCK_MAGIC_HI	0x314159
+#define BUNZIP2_BLOCK_MAGIC_LO	0x265359
+#define BUNZIP2_END_MAGIC_HI	0x177245
+#define BUNZIP2_END_MAGIC_LO	0x385090
+
+struct bunzip2_huff {
+	/* (symbol << 5) | code length, 0 for prefixes of longer codes */
+	u16 lookup[BUNZIP2_LOOKUP_SIZE];
+	/* canonical decoding of the codes that do not fit the lookup */
+	s32 limit[BUNZIP2_MAX_CODE_LEN + 1];
+	s32 base[BUNZIP2_MAX_CODE_LEN + 1];
+	u16 perm[BZ_MAX_ALPHA_SIZE];
+};
+
+struct bunzip2_ctx {
+	const u8 *in;
+	const u8 *in_end;
+	u32 buf;		/* bit buffer, next bit in the MSB */
+	int count;		/* valid bits in buf */
+	int overrun;		/* zero bytes fed in past in_end */
+
+	u32 *tt;		/* symbol in bits 0-7, link in bits 8-31 */
+	int tt_size;
+	int block_max;
+
+	int n_in_use;
+	u8 seq_to_unseq[256];
+	u8 selector[BZ_MAX_SELECTORS];
+	u8 len[BZ_N_GROUPS][BZ_MAX_ALPHA_SIZE];
+	struct bunzip2_huff huff[BZ_N_GROUPS];
+	u32 unzftab[256];
+};
+
+static inline void bunzip2_refill(struct bunzip2_ctx *c)
+{
+	int n;
+
+	if (c->in_end - c->in >= 4) {
+		/*
+		 * Bits of the fourth byte that do not fit are or-ed in
+		 * again, at the same position, by the next refill.
+		 */
+		c->buf |= get_unaligned_be32(c->in) >> c->count;
+		n = (32 - c->count) >> 3;
+		c->in += n;
+		c->count += n << 3;
+		return;
+	}
+
+	while (c->count <= 24) {
+		if (c->in < c->in_end)
+			c->buf |= (u32)*c->in++ << (24 - c->count);
+		else
+			c->overrun++;
+		c->count += 8;
+	}
+}
+
+/* Read 1 to 24 bits */
+static inline u32 bunzip2_bits(struct bunzip2_ctx *c, int n)
+{
+	u32 v;
+
+	if (c->count < n)
+		bunzip2_refill(c);
+	v = c->buf >> (32 - n);
+	c->buf <<= n;
+	c->count -= n;
+
+	return v;
+}
+
+/* Whether more bits were consumed than the input has */
+static inline int bunzip2_eof(struct bunzip2_ctx *c)
+{
+	return c->overrun * 8 > c->count;
+}
+
+static int bunzip2_make_huff(struct bunzip2_huff *h, const u8 *len, int alpha)
+{
+	int count[BUNZIP2_MAX_CODE_LEN + 1];
+	int next[BUNZIP2_MAX_CODE_LEN + 1];
+	int idx[BUNZIP2_MAX_CODE_LEN + 1];
+	s32 code;
+	int i, l, n;
+
+	memset(count, 0, sizeof(count));
+	for (i = 0; i < alpha; i++)
+		count[len[i]]++;
+
+	/* canonical codes: by length, then by symbol */
+	code = 0;
+	n = 0;
+	for (l = 1; l <= BUNZIP2_MAX_CODE_LEN; l++) {
+		next[l] = code;
+		idx[l] = n;
+		h->base[l] = code - n;
+		code += count[l];
+		n += count[l];
+		if (code > (1 << l))
+			return BZ_DATA_ERROR;	/* over-subscribed */
+		h->limit[l] = code - 1;
+		code <<= 1;
+	}
+
+	memset(h->lookup, 0, sizeof(h->lookup));
+	for (i = 0; i < alpha; i++) {
+		l = len[i];
+		h->perm[idx[l]++] = i;
+		code = next[l]++;
+		if (l <= BUNZIP2_LOOKUP_BITS) {
+			int shift = BUNZIP2_LOOKUP_BITS - l;
+			u16 e = (i << 5) | l;
+			int k;
+
+			for (k = code << shift; k < (code + 1) << shift; k++)
+				h->lookup[k] = e;
+		}
+	}
+
+	return BZ_OK;
+}
+
+/* Read the symbol map, selectors and Huffman tables of a block */
+static int bunzip2_read_tables(struct bunzip2_ctx *c, int *alpha_size,
+			       int *n_selectors)
+{
+	u8 mtf[BZ_N_GROUPS];
+	u16 in_use16;
+	int n_groups, n_sel;
+	int alpha, curr;
+	int i, j, t, ret;
+
+	in_use16 = bunzip2_bits(c, 16);
+	c->n_in_use = 0;
+	for (i = 0; i < 16; i++) {
+		if (!(in_use16 & (0x8000 >> i)))
+			continue;
+		t = bunzip2_bits(c, 16);
+		for (j = 0; j < 16; j++)
+			if (t & (0x8000 >> j))
+				c->seq_to_unseq[c->n_in_use++] = i * 16 + j;
+	}
+	if (c->n_in_use == 0)
+		return BZ_DATA_ERROR;
+	alpha = c->n_in_use + 2;
+
+	n_groups = bunzip2_bits(c, 3);
+	if (n_groups < 2 || n_groups > BZ_N_GROUPS)
+		return BZ_DATA_ERROR;
+	n_sel = bunzip2_bits(c, 15);
+	if (n_sel < 1)
+		return BZ_DATA_ERROR;
+
+	/* selectors are MTF coded in unary; excess ones are never used */
+	for (i = 0; i < n_groups; i++)
+		mtf[i] = i;
+	for (i = 0; i < n_sel; i++) {
+		u8 v;
+
+		for (j = 0; bunzip2_bits(c, 1); j++)
+			if (j + 1 >= n_groups || bunzip2_eof(c))
+				return BZ_DATA_ERROR;
+		v = mtf[j];
+		for (; j > 0; j--)
+			mtf[j] = mtf[j - 1];
+		mtf[0] = v;
+		if (i < BZ_MAX_SELECTORS)
+			c->selector[i] = v;
+	}
+	if (n_sel > BZ_MAX_SELECTORS)
+		n_sel = BZ_MAX_SELECTORS;
+
+	/* code lengths are delta coded */
+	for (t = 0; t < n_groups; t++) {
+		curr = bunzip2_bits(c, 5);
+		for (i = 0; i < alpha; i++) {
+			for (;;) {
+				if (curr < 1 || curr > BUNZIP2_MAX_CODE_LEN ||
+				    bunzip2_eof(c))
+					return BZ_DATA_ERROR;
+				if (!bunzip2_bits(c, 1))
+					break;
+				curr += bunzip2_bits(c, 1) ? -1 : 1;
+			}
+			c->len[t][i] = curr;
+		}
+		ret = bunzip2_make_huff(&c->huff[t], c->len[t], alpha);
+		if (ret)
+			return ret;
+	}
+
+	*alpha_size = alpha;
+	*n_selectors = n_sel;
+	return BZ_OK;
+}
+
+#ifdef __BIG_ENDIAN
+#define MTF_UP(w)	((w) >> 8)
+#define MTF_TOP(w)	((w) << 24)
+#define MTF_MASK(r)	(~0U << (24 - 8 * (r)))
+#else
+#define MTF_UP(w)	((w) << 8)
+#define MTF_TOP(w)	((w) >> 24)
+#define MTF_MASK(r)	(~0U >> (24 - 8 * (r)))
+#endif
+
+/*
+ * Move entry n of the MTF list to the front. The list is shifted up by
+ * one byte a word at a time, each word taking in the last byte of the
+ * word below it, rather than byte by byte.
+ */
+static inline u8 bunzip2_mtf(u32 *mtf, int n)
+{
+	u8 *list = (u8 *)mtf;
+	u8 uc = list[n];
+	int i = n >> 2;
+
+	if (n < 4) {
+		for (; n > 0; n--)
+			list[n] = list[n - 1];
+		list[0] = uc;
+		return uc;
+	}
+
+	/* the word holding entry n only shifts up to that entry */
+	mtf[i] = (mtf[i] & ~MTF_MASK(n & 3)) |
+		 ((MTF_UP(mtf[i]) | MTF_TOP(mtf[i - 1])) & MTF_MASK(n & 3));
+	for (i--; i > 0; i--)
+		mtf[i] = MTF_UP(mtf[i]) | MTF_TOP(mtf[i - 1]);
+	mtf[0] = MTF_UP(mtf[0]);
+	list[0] = uc;
+
+	return uc;
+}
+
+/*
+ * Huffman and MTF decode the symbols of a block into tt[], undoing the
+ * RUNA/RUNB zero run coding.
+ */
+static int bunzip2_read_symbols(struct bunzip2_ctx *c, int alpha,
+				int n_selectors, int *nblock_out)
+{
+	u32 mtf[256 / 4];
+	const struct bunzip2_huff *h = NULL;
+	u32 *tt = c->tt;
+	int eob = alpha - 1;
+	int group_no = -1, group_pos = 0;
+	int nblock = 0, run = 0, run_shift = 0;
+	int sym, n, i;
+	s32 code;
+	u16 e;
+	u8 uc;
+
+	for (i = 0; i < 256; i++)
+		((u8 *)mtf)[i] = i;
+	memset(c->unzftab, 0, sizeof(c->unzftab));
+
+	for (;;) {
+		if (group_pos == 0) {
+			if (++group_no >= n_selectors || bunzip2_eof(c))
+				return BZ_DATA_ERROR;
+			group_pos = BZ_G_SIZE;
+			h = &c->huff[c->selector[group_no]];
+		}
+		group_pos--;
+
+		if (c->count < BUNZIP2_MAX_CODE_LEN)
+			bunzip2_refill(c);
+		e = h->lookup[c->buf >> (32 - BUNZIP2_LOOKUP_BITS)];
+		if (e) {
+			n = e & 31;
+			sym = e >> 5;
+		} else {
+			u32 v = c->buf >> (32 - BUNZIP2_MAX_CODE_LEN);
+
+			for (n = BUNZIP2_LOOKUP_BITS + 1; ; n++) {
+				if (n > BUNZIP2_MAX_CODE_LEN)
+					return BZ_DATA_ERROR;
+				code = v >> (BUNZIP2_MAX_CODE_LEN - n);
+				if (code <= h->limit[n])
+					break;
+			}
+			code -= h->base[n];
+			if (code < 0 || code >= alpha)
+				return BZ_DATA_ERROR;
+			sym = h->perm[code];
+		}
+		c->buf <<= n;
+		c->count -= n;
+
+		if (sym <= BZ_RUNB) {
+			/* bijective base 2 run length of the front symbol */
+			if (run_shift > 20)
+				return BZ_DATA_ERROR;
+			run += (sym + 1) << run_shift++;
+			continue;
+		}
+
+		if (run) {
+			if (run > c->block_max - nblock)
+				return BZ_DATA_ERROR;
+			uc = c->seq_to_unseq[*(u8 *)mtf];
+			c->unzftab[uc] += run;
+			while (run--)
+				tt[nblock++] = uc;
+			run = 0;
+			run_shift = 0;
+		}
+
+		if (sym == eob)
+			break;
+
+		if (nblock >= c->block_max)
+			return BZ_DATA_ERROR;
+
+		uc = bunzip2_mtf(mtf, sym - 1);
+		uc = c->seq_to_unseq[uc];
+		c->unzftab[uc]++;
+		tt[nblock++] = uc;
+	}
+
+	if (bunzip2_eof(c))
+		return BZ_UNEXPECTED_EOF;
+
+	*nblock_out = nblock;
+	return BZ_OK;
+}
+
+/*
+ * Invert the BWT and undo the initial run length coding (four equal
+ * bytes followed by a repeat count) straight into the output buffer.
+ */
+static int bunzip2_output(struct bunzip2_ctx *c, int nblock, int orig_ptr,
+			  int randomised, u8 **opp, u8 *oend)
+{
+	u32 cftab[256];
+	u32 *tt = c->tt;
+	u8 *op = *opp;
+	int r_to_go = 0, r_pos = 0;
+	int last = -1, run = 0;
+	u32 pos, e, sum;
+	int i, ch;
+
+	sum = 0;
+	for (i = 0; i < 256; i++) {
+		cftab[i] = sum;
+		sum += c->unzftab[i];
+	}
+
+	/* link every position to its successor; all links are < nblock */
+	for (i = 0; i < nblock; i++)
+		tt[cftab[tt[i] & 0xff]++] |= i << 8;
+
+	WATCHDOG_RESET();
+
+	pos = tt[orig_ptr] >> 8;
+	for (i = 0; i < nblock; i++) {
+		e = tt[pos];
+		pos = e >> 8;
+		ch = e & 0xff;
+
+		if (randomised) {
+			if (r_to_go == 0) {
+				r_to_go = BZ2_rNums[r_pos];
+				if (++r_pos == 512)
+					r_pos = 0;
+			}
+			if (--r_to_go == 1)
+				ch ^= 1;
+		}
+
+		if (run == 4) {
+			if (oend - op < ch)
+				return BZ_OUTBUFF_FULL;
+			memset(op, last, ch);
+			op += ch;
+			run = 0;
+			continue;
+		}
+
+		if (op == oend)
+			return BZ_OUTBUFF_FULL;
+		*op++ = ch;
+		if (ch != last) {
+			last = ch;
+			run = 1;
+		} else {
+			run++;
+		}
+	}
+
+	*opp = op;
+	return BZ_OK;
+}
+
+static int bunzip2_stream(struct bunzip2_ctx *c, u8 **opp, u8 *oend)
+{
+	u32 stored_crc, crc, combined_crc = 0;
+	int block_size, orig_ptr, randomised;
+	int alpha, n_selectors, nblock;
+	u32 hi, lo;
+	u8 *start;
+	int ret;
+
+	if (bunzip2_bits(c, 8) != BZ_HDR_B || bunzip2_bits(c, 8) != BZ_HDR_Z ||
+	    bunzip2_bits(c, 8) != BZ_HDR_h)
+		return BZ_DATA_ERROR_MAGIC;
+	block_size = bunzip2_bits(c, 8) - BZ_HDR_0;
+	if (block_size < 1 || block_size > 9)
+		return BZ_DATA_ERROR_MAGIC;
+
+	c->block_max = block_size * 100000;
+	if (c->tt_size < c->block_max) {
+		free(c->tt);
+		c->tt = malloc(c->block_max * sizeof(u32));
+		if (!c->tt) {
+			c->tt_size = 0;
+			return BZ_MEM_ERROR;
+		}
+		c->tt_size = c->block_max;
+	}
+
+	for (;;) {
+		WATCHDOG_RESET();
+
+		hi = bunzip2_bits(c, 24);
+		lo = bunzip2_bits(c, 24);
+		if (bunzip2_eof(c))
+			return BZ_UNEXPECTED_EOF;
+		if (hi == BUNZIP2_END_MAGIC_HI && lo == BUNZIP2_END_MAGIC_LO)
+			break;
+		if (hi != BUNZIP2_BLOCK_MAGIC_HI || lo != BUNZIP2_BLOCK_MAGIC_LO)
+			return BZ_DATA_ERROR;
+
+		stored_crc = bunzip2_bits(c, 16) << 16;
+		stored_crc |= bunzip2_bits(c, 16);
+		randomised = bunzip2_bits(c, 1);
+		orig_ptr = bunzip2_bits(c, 24);
+
+		ret = bunzip2_read_tables(c, &alpha, &n_selectors);
+		if (ret)
+			return ret;
+		ret = bunzip2_read_symbols(c, alpha, n_selectors, &nblock);
+		if (ret)
+			return ret;
+		if (orig_ptr >= nblock)
+			return BZ_DATA_ERROR;
+
+		start = *opp;
+		ret = bunzip2_output(c, nblock, orig_ptr, randomised, opp, oend);
+		if (ret)
+			return ret;
+
+		BZ_INITIALISE_CRC(crc);
+		for (; start < *opp; start++)
+			BZ_UPDATE_CRC(crc, *start);
+		BZ_FINALISE_CRC(crc);
+		if (crc != stored_crc)
+			return BZ_DATA_ERROR;
+		combined_crc = ((combined_crc << 1) | (combined_crc >> 31)) ^ crc;
+	}
+
+	stored_crc = bunzip2_bits(c, 16) << 16;
+	stored_crc |= bunzip2_bits(c, 16);
+	if (bunzip2_eof(c))
+		return BZ_UNEXPECTED_EOF;
+	if (stored_crc != combined_crc)
+		return BZ_DATA_ERROR;
+
+	/* streams are padded to a byte boundary */
+	c->in -= (c->count >> 3) - c->overrun;
+	c->buf = 0;
+	c->count = 0;
+	c->overrun = 0;
+
+	return BZ_OK;
+}
+
+int bunzip2(void *dst, unsigned int *dstlen, const void *src,
+	    unsigned int srclen)
+{
+	struct bunzip2_ctx *c;
+	u8 *op = dst, *oend = op + *dstlen;
+	int ret;
+
+	c = malloc(sizeof(*c));
+	if (!c)
+		return BZ_MEM_ERROR;
+
+	perf_start(PERF_BUNZIP2);
+
+	memset(c, 0, sizeof(*c));
+	c->in = src;
+	c->in_end = c->in + srclen;
+
+	ret = bunzip2_stream(c, &op, oend);
+
+	/* further streams follow directly; ignore trailing padding */
+	while (ret == BZ_OK && c->in_end - c->in >= 4 &&
+	       c->in[0] == BZ_HDR_B && c->in[1] == BZ_HDR_Z &&
+	       c->in[2] == BZ_HDR_h)
+		ret = bunzip2_stream(c, &op, oend);
+
+	perf_stop(PERF_BUNZIP2);
+
+	free(c->tt);
+	free(c);
+	*dstlen = op - (u8 *)dst;
+
+	return ret;
+}
@@ -14,6 +14,7 @@
 #include <common.h>
 #endif
 #include <compiler.h>
+#include <perf.h>
 #include <u-boot/crc.h>
 
 #if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
@@ -220,7 +221,11 @@ uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 
 uint32_t ZEXPORT crc32 (uint32_t crc, const Bytef *p, uInt len)
 {
-     return crc32_no_comp(crc ^ 0xffffffffL, p, len) ^ 0xffffffffL;
+     perf_start(PERF_CRC32);
+     crc = crc32_no_comp(crc ^ 0xffffffffL, p, len) ^ 0xffffffffL;
+     perf_stop(PERF_CRC32);
+
+     return crc;
 }
 
 /*
@@ -0,0 +1,238 @@
+/*
+ * Some basic tests for the batched property edits of fdt_txn.c, accessed
+ * through the test_fdt_txn command. They are easiest to use with sandbox.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <command.h>
+#include <fdt_support.h>
+#include <libfdt.h>
+#include <malloc.h>
+
+/* The size of our test fdt blob */
+#define FDT_SIZE	(4 * 1024)
+
+/**
+ * Check if an operation failed, and if so, print an error
+ *
+ * @param oper_name	Name of operation
+ * @param err		Error code to check
+ *
+ * @return 0 if ok, -1 if there was an error
+ */
+static int fdt_checkerr(const char *oper_name, int err)
+{
+	if (err < 0) {
+		printf("%s: %s: %s\n", __func__, oper_name, fdt_strerror(err));
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Check the result of an operation and if incorrect, print an error
+ *
+ * @param oper_name	Name of operation
+ * @param expected	Expected value
+ * @param value		Actual value
+ *
+ * @return 0 if ok, -1 if there was an error
+ */
+static int checkval(const char *oper_name, int expected, int value)
+{
+	if (expected != value) {
+		printf("%s: %s: expected %d, but returned %d\n", __func__,
+		       oper_name, expected, value);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Check that a property of a node has the given string value
+ *
+ * @param fdt		Device tree pointer
+ * @param path		Path of the node
+ * @param name		Name of the property
+ * @param expect	Expected value, or NULL if the property must not exist
+ *
+ * @return 0 if ok, -1 if not
+ */
+static int checkprop(const void *fdt, const char *path, const char *name,
+		     const char *expect)
+{
+	const char *value;
+	int node, len;
+
+	node = fdt_path_offset(fdt, path);
+	if (node < 0) {
+		printf("%s: %s: %s\n", __func__, path, fdt_strerror(node));
+		return -1;
+	}
+
+	value = fdt_getprop(fdt, node, name, &len);
+	if (!expect && !value)
+		return 0;
+	if (!expect || !value || len != strlen(expect) + 1 ||
+	    memcmp(value, expect, len)) {
+		printf("%s: %s/%s: expected '%s', got '%s'\n", __func__, path,
+		       name, expect ? expect : "(none)",
+		       value ? value : "(none)");
+		return -1;
+	}
+
+	return 0;
+}
+
+#define CHECK(op)	if (fdt_checkerr(#op, op)) return -1
+#define CHECKVAL(op, expected)	\
+	if (checkval(#op, expected, op)) \
+		return -1
+#define CHECKOK(op)	CHECKVAL(op, 0)
+#define CHECKPROP(fdt, path, name, expect)	\
+	if (checkprop(fdt, path, name, expect)) \
+		return -1
+
+/*
+ * Make a test fdt with a node /p and its child /p/c
+ *
+ * @param fdt		Device tree pointer
+ * @param size		Size of device tree blob
+ * @param props		Give /p a property "a" if non-zero, no properties if 0
+ */
+static int make_fdt(void *fdt, int size, int props)
+{
+	CHECK(fdt_create(fdt, size));
+	CHECK(fdt_finish_reservemap(fdt));
+	CHECK(fdt_begin_node(fdt, ""));
+	CHECK(fdt_begin_node(fdt, "p"));
+	if (props)
+		CHECK(fdt_property_string(fdt, "a", "old"));
+	CHECK(fdt_begin_node(fdt, "c"));
+	CHECK(fdt_property_string(fdt, "x", "y"));
+	CHECK(fdt_end_node(fdt));
+	CHECK(fdt_end_node(fdt));
+	CHECK(fdt_end_node(fdt));
+	CHECK(fdt_finish(fdt));
+	CHECK(fdt_open_into(fdt, fdt, size));
+
+	return 0;
+}
+
+/* Pending values are visible before the commit and written by it */
+static int test_setprop(void *fdt)
+{
+	int node;
+
+	CHECKOK(make_fdt(fdt, FDT_SIZE, 1));
+	node = fdt_path_offset(fdt, "/p");
+	CHECK(node);
+
+	CHECKOK(fdt_txn_begin(fdt));
+	CHECKOK(fdt_setprop_string(fdt, node, "a", "changed"));
+	CHECKOK(fdt_setprop_string(fdt, node, "b", "new"));
+	CHECKOK(fdt_delprop(fdt, fdt_path_offset(fdt, "/p/c"), "x"));
+	CHECKPROP(fdt, "/p", "a", "changed");
+	CHECKPROP(fdt, "/p", "b", "new");
+	CHECKPROP(fdt, "/p/c", "x", NULL);
+	CHECKOK(fdt_txn_commit(fdt));
+
+	CHECKOK(fdt_check_header(fdt));
+	CHECKPROP(fdt, "/p", "a", "changed");
+	CHECKPROP(fdt, "/p", "b", "new");
+	CHECKPROP(fdt, "/p/c", "x", NULL);
+
+	return 0;
+}
+
+/* A new property stays ahead of a subnode added where it goes */
+static int test_add_subnode(void *fdt)
+{
+	int node;
+
+	CHECKOK(make_fdt(fdt, FDT_SIZE, 0));
+	node = fdt_path_offset(fdt, "/p");
+	CHECK(node);
+
+	CHECKOK(fdt_txn_begin(fdt));
+	CHECKOK(fdt_setprop_string(fdt, node, "b", "new"));
+	CHECK(fdt_add_subnode(fdt, node, "d"));
+	CHECKOK(fdt_txn_commit(fdt));
+
+	CHECKOK(fdt_check_header(fdt));
+	CHECKPROP(fdt, "/p", "b", "new");
+	CHECKPROP(fdt, "/p/c", "x", "y");
+	CHECK(fdt_path_offset(fdt, "/p/d"));
+
+	return 0;
+}
+
+/*
+ * A new property of a node without properties goes where its first
+ * subnode starts, and must stay there when that subnode is removed
+ */
+static int test_del_first_subnode(void *fdt)
+{
+	int node;
+
+	CHECKOK(make_fdt(fdt, FDT_SIZE, 0));
+	node = fdt_path_offset(fdt, "/p");
+	CHECK(node);
+
+	CHECKOK(fdt_txn_begin(fdt));
+	CHECKOK(fdt_setprop_string(fdt, node, "b", "new"));
+	CHECKOK(fdt_del_node(fdt, fdt_path_offset(fdt, "/p/c")));
+	CHECKOK(fdt_txn_commit(fdt));
+
+	CHECKOK(fdt_check_header(fdt));
+	CHECKPROP(fdt, "/p", "b", "new");
+	CHECKVAL(fdt_path_offset(fdt, "/p/c"), -FDT_ERR_NOTFOUND);
+
+	return 0;
+}
+
+static int do_test_fdt_txn(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	void *blob;
+	int ret;
+
+	blob = malloc(FDT_SIZE);
+	if (!blob) {
+		printf("%s: out of memory\n", __func__);
+		return 1;
+	}
+
+	ret = test_setprop(blob) || test_add_subnode(blob) ||
+	      test_del_first_subnode(blob);
+	/* close a transaction a failed test left open */
+	fdt_txn_commit(blob);
+	free(blob);
+	if (ret)
+		return 1;
+
+	printf("Test passed\n");
+	return 0;
+}
+
+U_BOOT_CMD(
+	test_fdt_txn, 1, 1, do_test_fdt_txn,
+	"test_fdt_txn",
+	"Run tests for batched device tree property edits");
@@ -27,6 +27,7 @@
 #include <image.h>
 #include <malloc.h>
 #include <u-boot/zlib.h>
+#include <perf.h>
 
 #define	ZALLOC_ALIGNMENT	16
 #define HEAD_CRC		2
@@ -53,7 +54,118 @@ void gzfree(void *x, void *addr, unsigned nb)
 	free (addr);
 }
 
-int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+/*
+ * Reusable raw inflate context. zlib's working state (the inflate_state
+ * and the 32K sliding window) is carved out of one arena that is
+ * allocated together with the context; every stream just resets it, so
+ * repeated decompression no longer goes through malloc()/free().
+ */
+struct gunzip_ctx {
+	z_stream	s;
+	unsigned char	*arena;
+	unsigned int	size;
+	unsigned int	used;
+};
+
+/* inflate_state needs a little under 10K, the window 1 << MAX_WBITS */
+#ifndef CONFIG_SYS_GUNZIP_ARENA_SIZE
+#define CONFIG_SYS_GUNZIP_ARENA_SIZE	((12 << 10) + (1 << MAX_WBITS))
+#endif
+
+static struct gunzip_ctx *gunzip_default_ctx;
+
+static void *gunzip_ctx_zalloc(void *x, unsigned items, unsigned size)
+{
+	struct gunzip_ctx *ctx = x;
+	void *p;
+
+	size *= items;
+	size = (size + ZALLOC_ALIGNMENT - 1) & ~(ZALLOC_ALIGNMENT - 1);
+
+	if (ctx->used + size > ctx->size) {
+		debug("gunzip: arena full, %u bytes from the heap\n", size);
+		return gzalloc(x, 1, size);
+	}
+
+	p = ctx->arena + ctx->used;
+	ctx->used += size;
+
+	return p;
+}
+
+static void gunzip_ctx_zfree(void *x, void *addr, unsigned nb)
+{
+	struct gunzip_ctx *ctx = x;
+	unsigned char *p = addr;
+
+	/* arena memory is only given back with the context */
+	if (p < ctx->arena || p >= ctx->arena + ctx->size)
+		gzfree(x, addr, nb);
+}
+
+/*
+ * Allocate an inflate context for raw deflate streams, as used by
+ * gunzip_ctx() and zunzip_ctx(). Returns NULL if out of memory.
+ */
+struct gunzip_ctx *gunzip_ctx_alloc(void)
+{
+	struct gunzip_ctx *ctx;
+	int r;
+
+	ctx = malloc(sizeof(*ctx));
+	if (!ctx)
+		return NULL;
+	memset(ctx, 0, sizeof(*ctx));
+
+	ctx->size = CONFIG_SYS_GUNZIP_ARENA_SIZE;
+	ctx->arena = memalign(ZALLOC_ALIGNMENT, ctx->size);
+	if (!ctx->arena) {
+		free(ctx);
+		return NULL;
+	}
+
+	ctx->s.zalloc = gunzip_ctx_zalloc;
+	ctx->s.zfree = gunzip_ctx_zfree;
+	ctx->s.opaque = ctx;
+
+	r = inflateInit2(&ctx->s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf ("Error: inflateInit2() returned %d\n", r);
+		free(ctx->arena);
+		free(ctx);
+		return NULL;
+	}
+
+	return ctx;
+}
+
+void gunzip_ctx_free(struct gunzip_ctx *ctx)
+{
+	if (!ctx)
+		return;
+
+	inflateEnd(&ctx->s);
+	free(ctx->arena);
+	free(ctx);
+}
+
+/*
+ * Context shared by gunzip() and zunzip(); allocated on first use and
+ * kept for good.
+ */
+static struct gunzip_ctx *gunzip_get_default_ctx(void)
+{
+	if (!gunzip_default_ctx) {
+		gunzip_default_ctx = gunzip_ctx_alloc();
+		if (!gunzip_default_ctx)
+			puts ("Error: out of memory for inflate context\n");
+	}
+
+	return gunzip_default_ctx;
+}
+
+int gunzip_ctx(struct gunzip_ctx *ctx, void *dst, int dstlen,
+	       unsigned char *src, unsigned long *lenp)
 {
 	int i, flags;
 
@@ -79,42 +191,62 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 		return (-1);
 	}
 
-	return zunzip(dst, dstlen, src, lenp, 1, i);
+	return zunzip_ctx(ctx, dst, dstlen, src, lenp, 1, i);
+}
+
+int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+{
+	struct gunzip_ctx *ctx = gunzip_get_default_ctx();
+
+	if (!ctx)
+		return -1;
+
+	return gunzip_ctx(ctx, dst, dstlen, src, lenp);
 }
 
 /*
  * Uncompress blocks compressed with zlib without headers
  */
-int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
-						int stoponerr, int offset)
+int zunzip_ctx(struct gunzip_ctx *ctx, void *dst, int dstlen,
+	       unsigned char *src, unsigned long *lenp,
+	       int stoponerr, int offset)
 {
-	z_stream s;
+	z_stream *s = &ctx->s;
 	int r;
 
-	s.zalloc = gzalloc;
-	s.zfree = gzfree;
-
-	r = inflateInit2(&s, -MAX_WBITS);
+	r = inflateReset(s);
 	if (r != Z_OK) {
-		printf ("Error: inflateInit2() returned %d\n", r);
+		printf ("Error: inflateReset() returned %d\n", r);
 		return -1;
 	}
-	s.next_in = src + offset;
-	s.avail_in = *lenp - offset;
-	s.next_out = dst;
-	s.avail_out = dstlen;
+	s->next_in = src + offset;
+	s->avail_in = *lenp - offset;
+	s->next_out = dst;
+	s->avail_out = dstlen;
+	perf_start(PERF_GUNZIP);
 	do {
-		r = inflate(&s, Z_FINISH);
+		r = inflate(s, Z_FINISH);
 		if (r != Z_STREAM_END && r != Z_BUF_ERROR && stoponerr == 1) {
+			perf_stop(PERF_GUNZIP);
 			printf("Error: inflate() returned %d\n", r);
-			inflateEnd(&s);
 			return -1;
 		}
-		s.avail_in = *lenp - offset - (int)(s.next_out - (unsigned char*)dst);
-		s.avail_out = dstlen;
+		s->avail_in = *lenp - offset - (int)(s->next_out - (unsigned char*)dst);
+		s->avail_out = dstlen;
 	} while (r == Z_BUF_ERROR);
-	*lenp = s.next_out - (unsigned char *) dst;
-	inflateEnd(&s);
+	perf_stop(PERF_GUNZIP);
+	*lenp = s->next_out - (unsigned char *) dst;
 
 	return 0;
 }
+
+int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
+						int stoponerr, int offset)
+{
+	struct gunzip_ctx *ctx = gunzip_get_default_ctx();
+
+	if (!ctx)
+		return -1;
+
+	return zunzip_ctx(ctx, dst, dstlen, src, lenp, stoponerr, offset);
+}
@@ -0,0 +1,408 @@
+/*
+ * Lookup index for a flattened device tree
+ *
+ * fdt_path_offset(), fdt_node_offset_by_phandle() and
+ * fdt_node_offset_by_compatible() walk the structure block from the
+ * start on every call, so a batch of fixups costs fixups * nodes tag
+ * reads. Between fdt_index_build() and fdt_index_clear() they are
+ * answered from hash tables built in one pass over the tree instead.
+ *
+ * fdt_rw.c keeps the node offsets in the index up to date as properties
+ * are added, resized or deleted. Adding, deleting or renaming a node,
+ * or changing a "compatible" or "phandle" property, marks the index
+ * stale and it is rebuilt on the next lookup. Every hit is checked
+ * against the tree before it is returned.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include "libfdt_env.h"
+#include <fdt.h>
+#include <libfdt.h>
+
+#include "libfdt_internal.h"
+
+#define FDT_INDEX_MAX_DEPTH	32
+
+#define FNV_OFFSET_BASIS	2166136261u
+#define FNV_PRIME		16777619u
+
+struct fdt_index_node {
+	int offset;
+	int parent;		/* index of the parent node, -1 for the root */
+	uint32_t path_hash;
+};
+
+struct fdt_index_compat {
+	uint32_t hash;
+	int node;
+	int next;		/* next entry with this hash, -1 at the end */
+};
+
+static struct {
+	const void *fdt;	/* tree the index is for, NULL if none */
+	int stale;
+	int struct_size;	/* size_dt_struct the offsets are valid for */
+
+	struct fdt_index_node *nodes;
+	int n_nodes;
+	struct fdt_index_compat *compat;
+	int n_compat, max_compat;
+
+	/* open addressing, entry + 1 or 0 for a free slot */
+	uint32_t mask;
+	int *path_tab;		/* nodes by path hash */
+	int *phandle_tab;	/* nodes by phandle */
+	int *compat_tab;	/* first compat entry by compatible hash */
+} idx;
+
+static uint32_t fdt_index_hash(uint32_t h, const char *s, int len)
+{
+	while (len--)
+		h = (h ^ (unsigned char)*s++) * FNV_PRIME;
+	return h;
+}
+
+static void fdt_index_free(void)
+{
+	free(idx.nodes);
+	free(idx.compat);
+	free(idx.path_tab);
+	free(idx.phandle_tab);
+	free(idx.compat_tab);
+	memset(&idx, 0, sizeof(idx));
+}
+
+/* Insert entry e under key into a table, after entries with that key */
+static void fdt_index_insert(int *tab, uint32_t key, int e)
+{
+	uint32_t i;
+
+	for (i = key & idx.mask; tab[i]; i = (i + 1) & idx.mask)
+		;
+	tab[i] = e + 1;
+}
+
+static int fdt_index_add_compat(int node, const char *list, int len)
+{
+	const char *end = list + len;
+	struct fdt_index_compat *c;
+	int n;
+
+	while (list < end) {
+		n = strnlen(list, end - list);
+		if (idx.n_compat == idx.max_compat) {
+			idx.max_compat = idx.max_compat ?
+					 idx.max_compat * 2 : 64;
+			c = realloc(idx.compat,
+				    idx.max_compat * sizeof(*c));
+			if (!c)
+				return -FDT_ERR_NOSPACE;
+			idx.compat = c;
+		}
+		c = &idx.compat[idx.n_compat++];
+		c->hash = fdt_index_hash(FNV_OFFSET_BASIS, list, n);
+		c->node = node;
+		c->next = -1;
+		list += n + 1;
+	}
+
+	return 0;
+}
+
+static int fdt_index_fill(void)
+{
+	const void *fdt = idx.fdt;
+	int stack[FDT_INDEX_MAX_DEPTH];
+	struct fdt_index_node *node;
+	int max_nodes = 0;
+	int offset, depth = 0;
+	const char *name;
+	uint32_t phandle, size;
+	int i, len, err;
+	int *tail;
+
+	/* the walk ends with depth -1 after the root's FDT_END_NODE */
+	for (offset = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(fdt, offset, &depth)) {
+		if (depth >= FDT_INDEX_MAX_DEPTH)
+			return -FDT_ERR_BADSTRUCTURE;
+
+		if (idx.n_nodes == max_nodes) {
+			max_nodes = max_nodes ? max_nodes * 2 : 128;
+			node = realloc(idx.nodes, max_nodes * sizeof(*node));
+			if (!node)
+				return -FDT_ERR_NOSPACE;
+			idx.nodes = node;
+		}
+
+		name = fdt_get_name(fdt, offset, &len);
+		if (!name)
+			return len;
+
+		node = &idx.nodes[idx.n_nodes];
+		node->offset = offset;
+		if (depth) {
+			node->parent = stack[depth - 1];
+			node->path_hash = fdt_index_hash(
+				idx.nodes[node->parent].path_hash, "/", 1);
+			node->path_hash = fdt_index_hash(node->path_hash,
+							 name, len);
+		} else {
+			node->parent = -1;
+			node->path_hash = FNV_OFFSET_BASIS;
+		}
+		stack[depth] = idx.n_nodes;
+
+		name = fdt_getprop(fdt, offset, "compatible", &len);
+		if (name) {
+			err = fdt_index_add_compat(idx.n_nodes, name, len);
+			if (err)
+				return err;
+		}
+
+		idx.n_nodes++;
+	}
+	if (offset < 0 && offset != -FDT_ERR_NOTFOUND)
+		return offset;
+
+	for (size = 16; size < 2 * idx.n_nodes || size < 2 * idx.n_compat;)
+		size <<= 1;
+	idx.mask = size - 1;
+	idx.path_tab = calloc(size, sizeof(int));
+	idx.phandle_tab = calloc(size, sizeof(int));
+	idx.compat_tab = calloc(size, sizeof(int));
+	tail = calloc(size, sizeof(int));
+	if (!idx.path_tab || !idx.phandle_tab || !idx.compat_tab || !tail) {
+		free(tail);
+		return -FDT_ERR_NOSPACE;
+	}
+
+	for (i = 0; i < idx.n_nodes; i++) {
+		node = &idx.nodes[i];
+		fdt_index_insert(idx.path_tab, node->path_hash, i);
+		phandle = fdt_get_phandle(fdt, node->offset);
+		if (phandle)
+			fdt_index_insert(idx.phandle_tab, phandle, i);
+	}
+
+	/* chain the compat entries of each hash, in tree order */
+	for (i = 0; i < idx.n_compat; i++) {
+		uint32_t h = idx.compat[i].hash;
+		uint32_t j;
+
+		for (j = h & idx.mask; idx.compat_tab[j]; j = (j + 1) & idx.mask)
+			if (idx.compat[idx.compat_tab[j] - 1].hash == h)
+				break;
+		if (idx.compat_tab[j])
+			idx.compat[tail[j]].next = i;
+		else
+			idx.compat_tab[j] = i + 1;
+		tail[j] = i;
+	}
+	free(tail);
+
+	idx.struct_size = fdt_size_dt_struct(fdt);
+	idx.stale = 0;
+
+	return 0;
+}
+
+int fdt_index_build(const void *fdt)
+{
+	int err;
+
+	FDT_CHECK_HEADER(fdt);
+
+	fdt_index_free();
+	idx.fdt = fdt;
+	err = fdt_index_fill();
+	if (err)
+		fdt_index_free();
+
+	return err;
+}
+
+void fdt_index_clear(void)
+{
+	fdt_index_free();
+}
+
+/* Return 1 if the index can answer lookups in fdt, rebuilding it if stale */
+static int fdt_index_ready(const void *fdt)
+{
+	if (!idx.fdt || idx.fdt != fdt)
+		return 0;
+	if (!idx.stale && idx.struct_size == fdt_size_dt_struct(fdt))
+		return 1;
+
+	return fdt_index_build(fdt) == 0;
+}
+
+/*
+ * Check that the path ending at end names node, comparing the node
+ * names from the node up to the root.
+ */
+static int fdt_index_path_match(const char *path, const char *end, int n)
+{
+	const char *p = end, *q, *name;
+	int len;
+
+	for (;;) {
+		while (p > path && p[-1] == '/')
+			p--;
+		if (idx.nodes[n].parent < 0)
+			return p == path;
+
+		for (q = p; q > path && q[-1] != '/'; q--)
+			;
+		name = fdt_get_name(idx.fdt, idx.nodes[n].offset, &len);
+		if (q == p || !name || len != p - q || memcmp(name, q, len))
+			return 0;
+
+		p = q;
+		n = idx.nodes[n].parent;
+	}
+}
+
+int _fdt_index_path(const void *fdt, const char *path, int *offsetp)
+{
+	const char *p = path, *q, *end;
+	uint32_t h = FNV_OFFSET_BASIS;
+	uint32_t i;
+	int n;
+
+	if (*path != '/' || !fdt_index_ready(fdt))
+		return 0;
+
+	end = path + strlen(path);
+	while (p < end) {
+		while (*p == '/')
+			p++;
+		if (!*p)
+			break;
+		for (q = p; *q && *q != '/'; q++)
+			;
+		h = fdt_index_hash(fdt_index_hash(h, "/", 1), p, q - p);
+		p = q;
+	}
+
+	/*
+	 * Only full node names are indexed: a miss may still be a path
+	 * that leaves out unit addresses, so leave that to the caller.
+	 */
+	for (i = h & idx.mask; idx.path_tab[i]; i = (i + 1) & idx.mask) {
+		n = idx.path_tab[i] - 1;
+		if (idx.nodes[n].path_hash == h &&
+		    fdt_index_path_match(path, end, n)) {
+			*offsetp = idx.nodes[n].offset;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int _fdt_index_phandle(const void *fdt, uint32_t phandle, int *offsetp)
+{
+	uint32_t i;
+	int offset;
+
+	if (!fdt_index_ready(fdt))
+		return 0;
+
+	*offsetp = -FDT_ERR_NOTFOUND;
+	for (i = phandle & idx.mask; idx.phandle_tab[i];
+	     i = (i + 1) & idx.mask) {
+		offset = idx.nodes[idx.phandle_tab[i] - 1].offset;
+		if (fdt_get_phandle(fdt, offset) == phandle) {
+			*offsetp = offset;
+			break;
+		}
+	}
+
+	return 1;
+}
+
+int _fdt_index_compatible(const void *fdt, int startoffset,
+			  const char *compatible, int *offsetp)
+{
+	uint32_t h = fdt_index_hash(FNV_OFFSET_BASIS, compatible,
+				    strlen(compatible));
+	uint32_t i;
+	int e, offset;
+
+	if (!fdt_index_ready(fdt))
+		return 0;
+
+	*offsetp = -FDT_ERR_NOTFOUND;
+	for (i = h & idx.mask; idx.compat_tab[i]; i = (i + 1) & idx.mask) {
+		e = idx.compat_tab[i] - 1;
+		if (idx.compat[e].hash == h)
+			break;
+	}
+	if (!idx.compat_tab[i])
+		return 1;
+
+	for (; e >= 0; e = idx.compat[e].next) {
+		offset = idx.nodes[idx.compat[e].node].offset;
+		if (offset > startoffset &&
+		    fdt_node_check_compatible(fdt, offset, compatible) == 0) {
+			*offsetp = offset;
+			break;
+		}
+	}
+
+	return 1;
+}
+
+void _fdt_index_splice(const void *fdt, int offset, int oldlen, int newlen)
+{
+	int delta = newlen - oldlen;
+	int i;
+
+	if (idx.fdt != fdt || idx.stale)
+		return;
+
+	for (i = 0; i < idx.n_nodes; i++) {
+		struct fdt_index_node *node = &idx.nodes[i];
+
+		if (node->offset < offset)
+			continue;
+		if (node->offset < offset + oldlen) {
+			/* a node was removed */
+			idx.stale = 1;
+			return;
+		}
+		node->offset += delta;
+	}
+	idx.struct_size += delta;
+}
+
+void _fdt_index_invalidate(const void *fdt)
+{
+	if (idx.fdt == fdt)
+		idx.stale = 1;
+}
+
+void _fdt_index_prop(const void *fdt, const char *name)
+{
+	if (idx.fdt == fdt && (!strcmp(name, "compatible") ||
+	    !strcmp(name, "phandle") || !strcmp(name, "linux,phandle")))
+		idx.stale = 1;
+}
@@ -166,6 +166,9 @@ int fdt_path_offset(const void *fdt, const char *path)
 
 	FDT_CHECK_HEADER(fdt);
 
+	if (_fdt_index_path(fdt, path, &offset))
+		return offset;
+
 	/* see if we have an alias */
 	if (*path != '/') {
 		const char *q = strchr(path, '/');
@@ -266,6 +269,11 @@ const struct fdt_property *fdt_get_property_namelen(const void *fdt,
 						    const char *name,
 						    int namelen, int *lenp)
 {
+	const struct fdt_property *pending;
+
+	if (_fdt_txn_get(fdt, offset, name, namelen, &pending, lenp))
+		return pending;
+
 	for (offset = fdt_first_property_offset(fdt, offset);
 	     (offset >= 0);
 	     (offset = fdt_next_property_offset(fdt, offset))) {
@@ -503,6 +511,9 @@ int fdt_node_offset_by_phandle(const void *fdt, uint32_t phandle)
 
 	FDT_CHECK_HEADER(fdt);
 
+	if (_fdt_index_phandle(fdt, phandle, &offset))
+		return offset;
+
 	/* FIXME: The algorithm here is pretty horrible: we
 	 * potentially scan each property of a node in
 	 * fdt_get_phandle(), then if that didn't find what
@@ -558,6 +569,9 @@ int fdt_node_offset_by_compatible(const void *fdt, int startoffset,
 
 	FDT_CHECK_HEADER(fdt);
 
+	if (_fdt_index_compatible(fdt, startoffset, compatible, &offset))
+		return offset;
+
 	/* FIXME: The algorithm here is pretty horrible: we scan each
 	 * property of a node in fdt_node_check_compatible(), then if
 	 * that didn't find what we want, we scan over them again
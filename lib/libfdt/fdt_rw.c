@@ -105,7 +105,9 @@ static int _fdt_splice(void *fdt, void *splicepoint, int oldlen, int newlen)
 
 	if (((p + oldlen) < p) || ((p + oldlen) > end))
 		return -FDT_ERR_BADOFFSET;
-	if ((end - oldlen + newlen) > ((char *)fdt + fdt_totalsize(fdt)))
+	/* leave room for the pending property edits */
+	if ((end - oldlen + newlen + _fdt_txn_grow(fdt)) >
+	    ((char *)fdt + fdt_totalsize(fdt)))
 		return -FDT_ERR_NOSPACE;
 	memmove(p + newlen, p + oldlen, end - p - oldlen);
 	return 0;
@@ -128,13 +130,16 @@ static int _fdt_splice_struct(void *fdt, void *p,
 			      int oldlen, int newlen)
 {
 	int delta = newlen - oldlen;
-	int err;
+	int offset, err;
 
 	if ((err = _fdt_splice(fdt, p, oldlen, newlen)))
 		return err;
 
 	fdt_set_size_dt_struct(fdt, fdt_size_dt_struct(fdt) + delta);
 	fdt_set_off_dt_strings(fdt, fdt_off_dt_strings(fdt) + delta);
+	offset = (char *)p - (char *)_fdt_offset_ptr(fdt, 0);
+	_fdt_index_splice(fdt, offset, oldlen, newlen);
+	_fdt_txn_splice(fdt, offset, oldlen, newlen);
 	return 0;
 }
 
@@ -272,6 +277,7 @@ int fdt_set_name(void *fdt, int nodeoffset, const char *name)
 		return err;
 
 	memcpy(namep, name, newlen+1);
+	_fdt_index_invalidate(fdt);
 	return 0;
 }
 
@@ -283,6 +289,11 @@ int fdt_setprop(void *fdt, int nodeoffset, const char *name,
 
 	FDT_RW_CHECK_HEADER(fdt);
 
+	err = _fdt_txn_edit(fdt, nodeoffset, name, val, len, FDT_TXN_SET);
+	if (err != 1)
+		return err;
+
+	_fdt_index_prop(fdt, name);
 	err = _fdt_resize_property(fdt, nodeoffset, name, len, &prop);
 	if (err == -FDT_ERR_NOTFOUND)
 		err = _fdt_add_property(fdt, nodeoffset, name, len, &prop);
@@ -301,6 +312,11 @@ int fdt_appendprop(void *fdt, int nodeoffset, const char *name,
 
 	FDT_RW_CHECK_HEADER(fdt);
 
+	err = _fdt_txn_edit(fdt, nodeoffset, name, val, len, FDT_TXN_APPEND);
+	if (err != 1)
+		return err;
+
+	_fdt_index_prop(fdt, name);
 	prop = fdt_get_property_w(fdt, nodeoffset, name, &oldlen);
 	if (prop) {
 		newlen = len + oldlen;
@@ -323,10 +339,15 @@ int fdt_appendprop(void *fdt, int nodeoffset, const char *name,
 int fdt_delprop(void *fdt, int nodeoffset, const char *name)
 {
 	struct fdt_property *prop;
-	int len, proplen;
+	int len, proplen, err;
 
 	FDT_RW_CHECK_HEADER(fdt);
 
+	err = _fdt_txn_edit(fdt, nodeoffset, name, NULL, 0, FDT_TXN_DEL);
+	if (err != 1)
+		return err;
+
+	_fdt_index_prop(fdt, name);
 	prop = fdt_get_property_w(fdt, nodeoffset, name, &len);
 	if (! prop)
 		return len;
@@ -372,6 +393,7 @@ int fdt_add_subnode_namelen(void *fdt, int parentoffset,
 	memcpy(nh->name, name, namelen);
 	endtag = (fdt32_t *)((char *)nh + nodelen - FDT_TAGSIZE);
 	*endtag = cpu_to_fdt32(FDT_END_NODE);
+	_fdt_index_invalidate(fdt);
 
 	return offset;
 }
@@ -427,6 +449,8 @@ int fdt_open_into(const void *fdt, void *buf, int bufsize)
 	char *tmp;
 
 	FDT_CHECK_HEADER(fdt);
+	if ((err = _fdt_txn_flush((void *)(uintptr_t)fdt)))
+		return err;
 
 	mem_rsv_size = (fdt_num_mem_rsv(fdt)+1)
 		* sizeof(struct fdt_reserve_entry);
@@ -483,9 +507,11 @@ int fdt_open_into(const void *fdt, void *buf, int bufsize)
 
 int fdt_pack(void *fdt)
 {
-	int mem_rsv_size;
+	int mem_rsv_size, err;
 
 	FDT_RW_CHECK_HEADER(fdt);
+	if ((err = _fdt_txn_flush(fdt)))
+		return err;
 
 	mem_rsv_size = (fdt_num_mem_rsv(fdt)+1)
 		* sizeof(struct fdt_reserve_entry);
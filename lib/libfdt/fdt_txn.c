@@ -0,0 +1,536 @@
+/*
+ * Batched property edits for a flattened device tree
+ *
+ * Each fdt_setprop() or fdt_delprop() splices the blob, moving the rest
+ * of the structure and strings blocks, so a run of fixups costs edits *
+ * blob size bytes moved. Between fdt_txn_begin() and fdt_txn_commit()
+ * property edits are only recorded, and the commit writes the new blob
+ * in a single pass from a copy of the old one.
+ *
+ * While edits are pending the blob itself is unchanged, so node and
+ * property offsets stay valid. fdt_getprop() and friends return the
+ * pending value of an edited property; walking the properties of a
+ * node with fdt_first_property_offset() still sees the old ones.
+ * Operations that change the structure, such as fdt_add_subnode() or
+ * fdt_del_node(), are made on the blob directly and the pending edits
+ * are moved with it. fdt_open_into() and fdt_pack() commit first.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include "libfdt_env.h"
+#include <fdt.h>
+#include <libfdt.h>
+#include <fdt_support.h>
+
+#include "libfdt_internal.h"
+
+struct fdt_txn_edit {
+	int node;		/* offset of the node */
+	int prop;		/* offset of the property in the blob, or -1 */
+	int oldlen;		/* size of that property record, 0 if none */
+	int pos;		/* where the new record goes */
+	int seq;		/* order of recording, to keep sort stable */
+	int len;		/* value length, -1 to delete the property */
+	int newname;		/* name is not in the strings block yet,
+				   2 for the edit that adds it */
+	int hidden;		/* deletion followed by a new property */
+	char *name;
+	struct fdt_property *rec;	/* header and value */
+};
+
+static struct {
+	void *fdt;		/* blob with a transaction open, or NULL */
+	struct fdt_txn_edit **edits;
+	int n_edits, max_edits;
+	int seq;
+	int grow;		/* upper bound of the growth of the blob */
+} txn;
+
+/* size of a property record with a value of len bytes, 0 for none */
+static int fdt_txn_reclen(int len)
+{
+	return len < 0 ? 0 : (int)sizeof(struct fdt_property) +
+			     FDT_TAGALIGN(len);
+}
+
+static void fdt_txn_free_edits(void)
+{
+	int i;
+
+	for (i = 0; i < txn.n_edits; i++)
+		free(txn.edits[i]);
+	txn.n_edits = 0;
+	txn.grow = 0;
+}
+
+/*
+ * Find the property in the blob itself, ignoring pending edits, and
+ * the size of its record
+ */
+static int fdt_txn_find_prop(const void *fdt, int node, const char *name,
+			     int namelen, int *reclen)
+{
+	const struct fdt_property *prop;
+	const char *s;
+	int offset, len;
+
+	for (offset = fdt_first_property_offset(fdt, node); offset >= 0;
+	     offset = fdt_next_property_offset(fdt, offset)) {
+		prop = fdt_get_property_by_offset(fdt, offset, &len);
+		if (!prop)
+			return len;
+		s = fdt_string(fdt, fdt32_to_cpu(prop->nameoff));
+		if (s && !strncmp(s, name, namelen) && !s[namelen]) {
+			*reclen = fdt_txn_reclen(len);
+			return offset;
+		}
+	}
+
+	return offset;
+}
+
+/* Return the index of the pending edit of a property, or -1 */
+static int fdt_txn_find(int node, const char *name, int namelen)
+{
+	struct fdt_txn_edit *e;
+	int i;
+
+	for (i = 0; i < txn.n_edits; i++) {
+		e = txn.edits[i];
+		if (e->node == node && !e->hidden &&
+		    !strncmp(e->name, name, namelen) && !e->name[namelen])
+			return i;
+	}
+
+	return -1;
+}
+
+int fdt_txn_begin(void *fdt)
+{
+	int err;
+
+	FDT_CHECK_HEADER(fdt);
+	if (fdt_version(fdt) < 17)
+		return -FDT_ERR_BADVERSION;
+
+	if (txn.fdt) {
+		err = fdt_txn_commit(txn.fdt);
+		if (err)
+			return err;
+	}
+	txn.fdt = fdt;
+
+	return 0;
+}
+
+/*
+ * Record a property edit, see the FDT_TXN_* modes. Returns 1 if there
+ * is no transaction open for fdt and the caller has to make the edit.
+ */
+int _fdt_txn_edit(void *fdt, int node, const char *name,
+		  const void *val, int len, int mode)
+{
+	const char *strtab = fdt_string(fdt, 0);
+	struct fdt_txn_edit *e, *old = NULL;
+	const char *str = NULL;
+	const void *cur = NULL;
+	int namelen = strlen(name);
+	int curlen = 0, newlen, grow;
+	int i, prop, oldlen = 0, recsize, err;
+
+	if (!txn.fdt || txn.fdt != fdt)
+		return 1;
+
+	if ((err = _fdt_check_node_offset(fdt, node)) < 0)
+		return err;
+
+	i = fdt_txn_find(node, name, namelen);
+	if (i >= 0)
+		old = txn.edits[i];
+	else if (mode == FDT_TXN_NOP)
+		return 1;
+
+	/* the current value, pending or not */
+	if (mode != FDT_TXN_SET) {
+		cur = fdt_getprop(fdt, node, name, &curlen);
+		if (!cur && (mode != FDT_TXN_APPEND ||
+			     curlen != -FDT_ERR_NOTFOUND))
+			return curlen;
+		if (mode == FDT_TXN_INPLACE && curlen != len)
+			return -FDT_ERR_NOSPACE;
+	}
+
+	if (mode == FDT_TXN_DEL || mode == FDT_TXN_NOP)
+		newlen = -1;
+	else if (mode == FDT_TXN_APPEND && cur)
+		newlen = curlen + len;
+	else
+		newlen = len;
+
+	if (old && old->len < 0 && newlen >= 0) {
+		/*
+		 * Set again after a deletion: keep the deletion and add
+		 * a new property, which fdt_setprop() puts first.
+		 */
+		old->hidden = 1;
+		old = NULL;
+		prop = -FDT_ERR_NOTFOUND;
+	} else if (old) {
+		prop = old->prop;
+		oldlen = old->oldlen;
+	} else {
+		prop = fdt_txn_find_prop(fdt, node, name, namelen, &oldlen);
+		if (prop < 0 && prop != -FDT_ERR_NOTFOUND)
+			return prop;
+	}
+	if (!old && prop < 0)
+		str = _fdt_find_string(strtab, fdt_size_dt_strings(fdt), name);
+
+	/* check there will be room, as fdt_setprop() would */
+	grow = txn.grow + fdt_txn_reclen(newlen) - oldlen;
+	if (old)
+		grow -= fdt_txn_reclen(old->len) - oldlen;
+	else if (prop < 0 && !str)
+		grow += namelen + 1;
+	if (fdt_off_dt_strings(fdt) + fdt_size_dt_strings(fdt) + grow >
+	    fdt_totalsize(fdt))
+		return -FDT_ERR_NOSPACE;
+
+	/* a deletion still keeps the name offset in its record */
+	recsize = newlen < 0 ? (int)sizeof(*e->rec) : fdt_txn_reclen(newlen);
+	e = malloc(sizeof(*e) + recsize + namelen + 1);
+	if (!e)
+		goto no_mem;
+	memset(e, 0, sizeof(*e));
+	e->node = node;
+	e->prop = prop;
+	e->oldlen = oldlen;
+	e->len = newlen;
+	e->rec = (struct fdt_property *)(e + 1);
+	e->name = (char *)e->rec + recsize;
+	memcpy(e->name, name, namelen + 1);
+
+	if (old) {
+		e->pos = old->pos;
+		e->seq = old->seq;
+		e->newname = old->newname;
+		e->rec->nameoff = old->rec->nameoff;
+	} else if (prop >= 0) {
+		e->pos = prop;
+		e->rec->nameoff = ((const struct fdt_property *)
+			fdt_offset_ptr(fdt, prop, sizeof(*e->rec)))->nameoff;
+	} else {
+		/* new properties go first, as _fdt_add_property() does */
+		fdt_next_tag(fdt, node, &e->pos);
+		e->newname = !str;
+		if (str)
+			e->rec->nameoff = cpu_to_fdt32(str - strtab);
+	}
+
+	if (newlen >= 0) {
+		if (mode != FDT_TXN_APPEND || !cur)
+			curlen = 0;
+		e->rec->tag = cpu_to_fdt32(FDT_PROP);
+		e->rec->len = cpu_to_fdt32(newlen);
+		if (curlen)
+			memcpy(e->rec->data, cur, curlen);
+		if (newlen > curlen)
+			memcpy(e->rec->data + curlen, val, newlen - curlen);
+		memset(e->rec->data + newlen, 0,
+		       FDT_TAGALIGN(newlen) - newlen);
+	}
+
+	if (old) {
+		free(old);
+		txn.edits[i] = e;
+	} else {
+		if (txn.n_edits == txn.max_edits) {
+			struct fdt_txn_edit **edits;
+			int max = txn.max_edits ? txn.max_edits * 2 : 32;
+
+			edits = realloc(txn.edits, max * sizeof(*edits));
+			if (!edits) {
+				free(e);
+				goto no_mem;
+			}
+			txn.edits = edits;
+			txn.max_edits = max;
+		}
+		e->seq = txn.seq++;
+		txn.edits[txn.n_edits++] = e;
+	}
+	txn.grow = grow;
+	_fdt_index_prop(fdt, name);
+
+	return 0;
+
+no_mem:
+	/* give up batching: commit and let the caller make this edit */
+	err = fdt_txn_commit(fdt);
+	if (err)
+		return err;
+	return 1;
+}
+
+/*
+ * Return 1 and the pending value in *propp if the property has a
+ * pending edit, *propp is NULL and *lenp -FDT_ERR_NOTFOUND if it is to
+ * be deleted.
+ */
+int _fdt_txn_get(const void *fdt, int node, const char *name, int namelen,
+		 const struct fdt_property **propp, int *lenp)
+{
+	struct fdt_txn_edit *e;
+	int i;
+
+	if (!txn.fdt || txn.fdt != fdt || !txn.n_edits)
+		return 0;
+
+	i = fdt_txn_find(node, name, namelen);
+	if (i < 0)
+		return 0;
+
+	e = txn.edits[i];
+	if (e->len < 0) {
+		*propp = NULL;
+		if (lenp)
+			*lenp = -FDT_ERR_NOTFOUND;
+	} else {
+		*propp = e->rec;
+		if (lenp)
+			*lenp = e->len;
+	}
+
+	return 1;
+}
+
+/* Room the pending edits need, which other changes must leave free */
+int _fdt_txn_grow(const void *fdt)
+{
+	if (!txn.fdt || txn.fdt != fdt)
+		return 0;
+
+	return txn.grow;
+}
+
+/*
+ * The structure block was spliced by an operation made directly on the
+ * blob, such as fdt_add_subnode(): move the pending edits with it, and
+ * drop those of properties or nodes that were removed.
+ */
+void _fdt_txn_splice(const void *fdt, int offset, int oldlen, int newlen)
+{
+	int delta = newlen - oldlen;
+	int end = offset + oldlen;
+	struct fdt_txn_edit *e;
+	int i, j;
+
+	if (!txn.fdt || txn.fdt != fdt)
+		return;
+
+	for (i = j = 0; i < txn.n_edits; i++) {
+		e = txn.edits[i];
+		if ((e->node >= offset && e->node < end) ||
+		    (e->prop >= offset && e->prop < end)) {
+			txn.grow -= fdt_txn_reclen(e->len) - e->oldlen;
+			free(e);
+			continue;
+		}
+		if (e->node >= end)
+			e->node += delta;
+		if (e->prop >= end)
+			e->prop += delta;
+		/*
+		 * A new property moves only with what follows the spliced
+		 * range: it stays ahead of a subnode inserted where it goes,
+		 * and in place when the subnode there is removed.
+		 */
+		if (e->pos >= end && e->pos > offset)
+			e->pos += delta;
+		txn.edits[j++] = e;
+	}
+	txn.n_edits = j;
+}
+
+static int fdt_txn_cmp(const void *a, const void *b)
+{
+	const struct fdt_txn_edit *x = *(const struct fdt_txn_edit **)a;
+	const struct fdt_txn_edit *y = *(const struct fdt_txn_edit **)b;
+
+	/*
+	 * At the same position, new properties go before a replaced one,
+	 * the last added first as if each had been inserted at the time.
+	 */
+	if (x->pos != y->pos)
+		return x->pos - y->pos;
+	if (!x->oldlen != !y->oldlen)
+		return !y->oldlen - !x->oldlen;
+	if (!x->oldlen)
+		return y->seq - x->seq;
+	return x->seq - y->seq;
+}
+
+/*
+ * Make the pending edits one at a time with the normal splicing calls,
+ * from the end of the blob back so that the offsets recorded for the
+ * earlier ones stay valid. Used when there is no memory for a copy.
+ */
+static int fdt_txn_replay(void *fdt)
+{
+	struct fdt_txn_edit *e;
+	int i, err = 0;
+
+	txn.fdt = NULL;
+	for (i = txn.n_edits - 1; i >= 0 && !err; i--) {
+		e = txn.edits[i];
+		if (e->len < 0)
+			err = fdt_delprop(fdt, e->node, e->name);
+		else
+			err = fdt_setprop(fdt, e->node, e->name,
+					  e->rec->data, e->len);
+	}
+
+	return err;
+}
+
+int fdt_txn_commit(void *fdt)
+{
+	char *base, *copy, *p;
+	struct fdt_txn_edit *e;
+	int struct_len, strings_len, tail_len;
+	int delta = 0, added = 0;
+	int i, j, cursor, err = 0;
+
+	if (!txn.fdt || txn.fdt != fdt)
+		return 0;
+
+	/* deleting a property that never existed is a no-op */
+	for (i = j = 0; i < txn.n_edits; i++) {
+		e = txn.edits[i];
+		if (e->len < 0 && e->prop < 0)
+			free(e);
+		else
+			txn.edits[j++] = e;
+	}
+	txn.n_edits = j;
+	if (!txn.n_edits)
+		goto out;
+
+	qsort(txn.edits, txn.n_edits, sizeof(*txn.edits), fdt_txn_cmp);
+
+	/* the structure block, and any gap up to the strings block */
+	struct_len = fdt_off_dt_strings(fdt) - fdt_off_dt_struct(fdt);
+	strings_len = fdt_size_dt_strings(fdt);
+
+	/*
+	 * Give new names their place at the end of the strings block;
+	 * the first edit using a name owns its copy.
+	 */
+	for (i = 0; i < txn.n_edits; i++) {
+		e = txn.edits[i];
+		delta += fdt_txn_reclen(e->len) - e->oldlen;
+		if (!e->newname)
+			continue;
+		for (j = 0; j < i; j++)
+			if (txn.edits[j]->newname &&
+			    !strcmp(txn.edits[j]->name, e->name))
+				break;
+		if (j < i) {
+			e->rec->nameoff = txn.edits[j]->rec->nameoff;
+			e->newname = 1;
+		} else {
+			e->rec->nameoff = cpu_to_fdt32(strings_len + added);
+			e->newname = 2;
+			added += strlen(e->name) + 1;
+		}
+	}
+
+	if (fdt_off_dt_strings(fdt) + delta + strings_len + added >
+	    fdt_totalsize(fdt)) {
+		err = -FDT_ERR_NOSPACE;
+		goto out;
+	}
+
+	copy = malloc(struct_len + strings_len);
+	if (!copy) {
+		err = fdt_txn_replay(fdt);
+		goto out;
+	}
+	base = (char *)fdt + fdt_off_dt_struct(fdt);
+	memcpy(copy, base, struct_len + strings_len);
+
+	/* write the new structure block, edits in place of old records */
+	p = base;
+	cursor = 0;
+	for (i = 0; i < txn.n_edits; i++) {
+		e = txn.edits[i];
+		tail_len = e->pos - cursor;
+		memcpy(p, copy + cursor, tail_len);
+		p += tail_len;
+		if (e->len >= 0) {
+			memcpy(p, e->rec, fdt_txn_reclen(e->len));
+			p += fdt_txn_reclen(e->len);
+		}
+		cursor = e->pos + e->oldlen;
+	}
+	memcpy(p, copy + cursor, struct_len - cursor);
+	p += struct_len - cursor;
+
+	/* then the strings block and the new names */
+	memcpy(p, copy + struct_len, strings_len);
+	p += strings_len;
+	for (i = 0; i < txn.n_edits; i++) {
+		e = txn.edits[i];
+		if (e->newname == 2) {
+			strcpy(p, e->name);
+			p += strlen(e->name) + 1;
+		}
+	}
+	free(copy);
+
+	fdt_set_size_dt_struct(fdt, fdt_size_dt_struct(fdt) + delta);
+	fdt_set_off_dt_strings(fdt, fdt_off_dt_strings(fdt) + delta);
+	fdt_set_size_dt_strings(fdt, strings_len + added);
+
+	for (i = txn.n_edits - 1; i >= 0; i--) {
+		e = txn.edits[i];
+		_fdt_index_splice(fdt, e->pos, e->oldlen,
+				  fdt_txn_reclen(e->len));
+	}
+
+out:
+	fdt_txn_free_edits();
+	txn.fdt = NULL;
+
+	return err;
+}
+
+/* Commit the pending edits and keep the transaction open */
+int _fdt_txn_flush(void *fdt)
+{
+	int err;
+
+	if (!txn.fdt || txn.fdt != fdt || !txn.n_edits)
+		return 0;
+
+	err = fdt_txn_commit(fdt);
+	txn.fdt = fdt;
+
+	return err;
+}
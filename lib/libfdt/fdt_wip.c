@@ -63,7 +63,11 @@ int fdt_setprop_inplace(void *fdt, int nodeoffset, const char *name,
 			const void *val, int len)
 {
 	void *propval;
-	int proplen;
+	int proplen, err;
+
+	err = _fdt_txn_edit(fdt, nodeoffset, name, val, len, FDT_TXN_INPLACE);
+	if (err != 1)
+		return err;
 
 	propval = fdt_getprop_w(fdt, nodeoffset, name, &proplen);
 	if (! propval)
@@ -72,6 +76,7 @@ int fdt_setprop_inplace(void *fdt, int nodeoffset, const char *name,
 	if (proplen != len)
 		return -FDT_ERR_NOSPACE;
 
+	_fdt_index_prop(fdt, name);
 	memcpy(propval, val, len);
 	return 0;
 }
@@ -87,12 +92,17 @@ static void _fdt_nop_region(void *start, int len)
 int fdt_nop_property(void *fdt, int nodeoffset, const char *name)
 {
 	struct fdt_property *prop;
-	int len;
+	int len, err;
+
+	err = _fdt_txn_edit(fdt, nodeoffset, name, NULL, 0, FDT_TXN_NOP);
+	if (err != 1)
+		return err;
 
 	prop = fdt_get_property_w(fdt, nodeoffset, name, &len);
 	if (! prop)
 		return len;
 
+	_fdt_index_prop(fdt, name);
 	_fdt_nop_region(prop, len + sizeof(*prop));
 
 	return 0;
@@ -116,7 +126,12 @@ int fdt_nop_node(void *fdt, int nodeoffset)
 	if (endoffset < 0)
 		return endoffset;
 
+	/* drop pending edits in the node, nothing moves */
+	_fdt_txn_splice(fdt, nodeoffset, endoffset - nodeoffset,
+			endoffset - nodeoffset);
+
 	_fdt_nop_region(fdt_offset_ptr_w(fdt, nodeoffset, 0),
 			endoffset - nodeoffset);
+	_fdt_index_invalidate(fdt);
 	return 0;
 }
@@ -92,4 +92,74 @@ static inline struct fdt_reserve_entry *_fdt_mem_rsv_w(void *fdt, int n)
 
 #define FDT_SW_MAGIC		(~FDT_MAGIC)
 
+/* U-Boot: lookup index kept by fdt_index.c, see fdt_index_build() */
+#ifdef CONFIG_OF_LIBFDT_INDEX
+int _fdt_index_path(const void *fdt, const char *path, int *offsetp);
+int _fdt_index_phandle(const void *fdt, uint32_t phandle, int *offsetp);
+int _fdt_index_compatible(const void *fdt, int startoffset,
+			  const char *compatible, int *offsetp);
+void _fdt_index_splice(const void *fdt, int offset, int oldlen, int newlen);
+void _fdt_index_invalidate(const void *fdt);
+void _fdt_index_prop(const void *fdt, const char *name);
+#else
+static inline int _fdt_index_path(const void *fdt, const char *path,
+				  int *offsetp)
+{
+	return 0;
+}
+static inline int _fdt_index_phandle(const void *fdt, uint32_t phandle,
+				     int *offsetp)
+{
+	return 0;
+}
+static inline int _fdt_index_compatible(const void *fdt, int startoffset,
+					const char *compatible, int *offsetp)
+{
+	return 0;
+}
+static inline void _fdt_index_splice(const void *fdt, int offset,
+				     int oldlen, int newlen) {}
+static inline void _fdt_index_invalidate(const void *fdt) {}
+static inline void _fdt_index_prop(const void *fdt, const char *name) {}
+#endif
+
+/* U-Boot: pending property edits kept by fdt_txn.c, see fdt_txn_begin() */
+#define FDT_TXN_SET		0	/* new value */
+#define FDT_TXN_APPEND		1	/* value appended */
+#define FDT_TXN_INPLACE		2	/* new value of the same size */
+#define FDT_TXN_DEL		3	/* property deleted */
+#define FDT_TXN_NOP		4	/* deleted if it has a pending edit */
+
+#ifdef CONFIG_OF_LIBFDT_TXN
+int _fdt_txn_edit(void *fdt, int node, const char *name,
+		  const void *val, int len, int mode);
+int _fdt_txn_get(const void *fdt, int node, const char *name, int namelen,
+		 const struct fdt_property **propp, int *lenp);
+int _fdt_txn_grow(const void *fdt);
+void _fdt_txn_splice(const void *fdt, int offset, int oldlen, int newlen);
+int _fdt_txn_flush(void *fdt);
+#else
+static inline int _fdt_txn_edit(void *fdt, int node, const char *name,
+				const void *val, int len, int mode)
+{
+	return 1;
+}
+static inline int _fdt_txn_get(const void *fdt, int node, const char *name,
+			       int namelen, const struct fdt_property **propp,
+			       int *lenp)
+{
+	return 0;
+}
+static inline int _fdt_txn_grow(const void *fdt)
+{
+	return 0;
+}
+static inline void _fdt_txn_splice(const void *fdt, int offset,
+				   int oldlen, int newlen) {}
+static inline int _fdt_txn_flush(void *fdt)
+{
+	return 0;
+}
+#endif
+
 #endif /* _LIBFDT_INTERNAL_H */
@@ -335,6 +335,28 @@ int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
 	return 0;
 }
 
+/*
+ * Return 1 if [base, base + size) lies within one memory region and
+ * overlaps no reserved region, so data already there can be used as is.
+ */
+int lmb_is_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
+{
+	int i;
+
+	if (base + size < base)
+		return 0;
+
+	for (i = 0; i < lmb->memory.cnt; i++) {
+		phys_addr_t rgnbase = lmb->memory.region[i].base;
+		phys_size_t rgnsize = lmb->memory.region[i].size;
+
+		if (base >= rgnbase && base + size <= rgnbase + rgnsize)
+			return lmb_overlaps_region(&lmb->reserved, base,
+						   size) < 0;
+	}
+	return 0;
+}
+
 void __board_lmb_reserve(struct lmb *lmb)
 {
 	/* please define platform specific board_lmb_reserve() */
@@ -0,0 +1,322 @@
+/*
+ * LZ4 decompression
+ *
+ * Decoder for the LZ4 block format and the frame format of the lz4
+ * command line tool, see
+ * https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md and
+ * https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <lz4.h>
+#include <perf.h>
+#include <asm/errno.h>
+#include <asm/unaligned.h>
+
+#define LZ4F_MAGIC		0x184d2204
+#define LZ4F_SKIP_MAGIC		0x184d2a50	/* low nibble is free */
+#define LZ4F_SKIP_MASK		0xfffffff0
+#define LZ4F_LEGACY_MAGIC	0x184c2102
+#define LZ4F_LEGACY_BLOCK	(8 << 20)
+
+/* frame descriptor FLG byte */
+#define LZ4F_FLG_VERSION(x)	(((x) >> 6) & 3)
+#define LZ4F_FLG_INDEP		(1 << 5)
+#define LZ4F_FLG_BLOCK_SUM	(1 << 4)
+#define LZ4F_FLG_CONTENT_SIZE	(1 << 3)
+#define LZ4F_FLG_CONTENT_SUM	(1 << 2)
+#define LZ4F_FLG_RESERVED	(1 << 1)
+#define LZ4F_FLG_DICT_ID	(1 << 0)
+
+/* frame descriptor BD byte */
+#define LZ4F_BD_MAX_SIZE(x)	(((x) >> 4) & 7)
+#define LZ4F_BD_RESERVED	0x8f
+
+#define LZ4F_BLOCK_UNCOMPRESSED	0x80000000
+
+#define LZ4_MIN_MATCH		4
+
+/* below this length a plain byte loop beats a call to memcpy() */
+#define LZ4_SHORT_COPY		16
+
+static inline u8 *lz4_copy(u8 *op, const u8 *ip, size_t len)
+{
+	if (len < LZ4_SHORT_COPY) {
+		while (len--)
+			*op++ = *ip++;
+		return op;
+	}
+	memcpy(op, ip, len);
+	return op + len;
+}
+
+/*
+ * Copy a match of len bytes from off bytes back in the output. When the
+ * source overlaps the destination the first off bytes repeat, so each
+ * memcpy() doubles the pattern copied so far.
+ */
+static inline u8 *lz4_copy_match(u8 *op, size_t off, size_t len)
+{
+	const u8 *from = op - off;
+
+	if (len < LZ4_SHORT_COPY) {
+		while (len--)
+			*op++ = *from++;
+		return op;
+	}
+
+	if (off == 1) {
+		memset(op, *from, len);
+		return op + len;
+	}
+
+	while (off < len) {
+		memcpy(op, from, off);
+		op += off;
+		len -= off;
+		off <<= 1;
+	}
+	memcpy(op, from, len);
+	return op + len;
+}
+
+/* Read a length continuation: bytes are added up while they are 255 */
+static inline int lz4_length(const u8 **ipp, const u8 *iend, size_t *len)
+{
+	const u8 *ip = *ipp;
+	unsigned int b;
+
+	do {
+		if (ip >= iend)
+			return -EINVAL;
+		b = *ip++;
+		*len += b;
+	} while (b == 255);
+
+	*ipp = ip;
+	return 0;
+}
+
+/*
+ * Decode one LZ4 block of srcn bytes to *opp, advancing *opp. Matches
+ * may reach back as far as base, which is the start of the block for
+ * independent blocks and the start of the frame otherwise.
+ */
+static int lz4_block(const u8 *ip, size_t srcn, u8 *base, u8 **opp, u8 *oend)
+{
+	const u8 *iend = ip + srcn;
+	u8 *op = *opp;
+	size_t lit, len, off;
+	unsigned int token;
+
+	for (;;) {
+		if (ip >= iend)
+			return -EINVAL;
+		token = *ip++;
+
+		lit = token >> 4;
+		if (lit == 15 && lz4_length(&ip, iend, &lit))
+			return -EINVAL;
+		if ((size_t)(iend - ip) < lit)
+			return -EINVAL;
+		if ((size_t)(oend - op) < lit)
+			return -ENOBUFS;
+		op = lz4_copy(op, ip, lit);
+		ip += lit;
+
+		/* the last sequence has literals only */
+		if (ip == iend)
+			break;
+
+		if (iend - ip < 2)
+			return -EINVAL;
+		off = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (off == 0 || (size_t)(op - base) < off)
+			return -EINVAL;
+
+		len = token & 15;
+		if (len == 15 && lz4_length(&ip, iend, &len))
+			return -EINVAL;
+		len += LZ4_MIN_MATCH;
+		if ((size_t)(oend - op) < len)
+			return -ENOBUFS;
+		op = lz4_copy_match(op, off, len);
+	}
+
+	*opp = op;
+	return 0;
+}
+
+/* Decode a frame starting after the magic number, return its length */
+static int lz4_frame(const u8 *src, const u8 *end, u8 **opp, u8 *oend)
+{
+	const u8 *ip = src;
+	u8 *frame = *opp;
+	u64 content_size = 0;
+	u32 block, block_max;
+	u8 flg, bd;
+	int ret;
+
+	if (end - ip < 3)
+		return -EINVAL;
+	flg = *ip++;
+	bd = *ip++;
+	if (LZ4F_FLG_VERSION(flg) != 1)
+		return -EPROTONOSUPPORT;
+	if (flg & (LZ4F_FLG_RESERVED | LZ4F_FLG_DICT_ID))
+		return -EPROTONOSUPPORT;
+	if ((bd & LZ4F_BD_RESERVED) || LZ4F_BD_MAX_SIZE(bd) < 4)
+		return -EINVAL;
+	block_max = 1 << (8 + 2 * LZ4F_BD_MAX_SIZE(bd));
+
+	if (flg & LZ4F_FLG_CONTENT_SIZE) {
+		if (end - ip < 8 + 1)
+			return -EINVAL;
+		content_size = get_unaligned_le64(ip);
+		ip += 8;
+		if (content_size > (size_t)(oend - *opp))
+			return -ENOBUFS;
+	}
+	ip++;			/* header checksum */
+
+	for (;;) {
+		if (end - ip < 4)
+			return -EINVAL;
+		block = get_unaligned_le32(ip);
+		ip += 4;
+		if (block == 0)
+			break;
+
+		if ((block & ~LZ4F_BLOCK_UNCOMPRESSED) > block_max ||
+		    (size_t)(end - ip) < (block & ~LZ4F_BLOCK_UNCOMPRESSED))
+			return -EINVAL;
+
+		if (block & LZ4F_BLOCK_UNCOMPRESSED) {
+			block &= ~LZ4F_BLOCK_UNCOMPRESSED;
+			if ((size_t)(oend - *opp) < block)
+				return -ENOBUFS;
+			*opp = lz4_copy(*opp, ip, block);
+		} else {
+			ret = lz4_block(ip, block, flg & LZ4F_FLG_INDEP ?
+					*opp : frame, opp, oend);
+			if (ret)
+				return ret;
+		}
+		ip += block;
+
+		if (flg & LZ4F_FLG_BLOCK_SUM)
+			ip += 4;
+	}
+
+	if (flg & LZ4F_FLG_CONTENT_SUM)
+		ip += 4;
+	if (ip > end)
+		return -EINVAL;
+
+	if ((flg & LZ4F_FLG_CONTENT_SIZE) &&
+	    (u64)(*opp - frame) != content_size)
+		return -EINVAL;
+
+	return ip - src;
+}
+
+/*
+ * Legacy frames are a sequence of independent blocks of up to 8MB of
+ * output each, without an end mark: they end with the input or at the
+ * next magic number. Linux kernels built with CONFIG_KERNEL_LZ4 carry
+ * the uncompressed size as a last 32 bit word after the blocks, which
+ * ends the frame too. out is the start of the whole output.
+ */
+static int lz4_legacy_frame(const u8 *src, const u8 *end, u8 *out,
+			    u8 **opp, u8 *oend)
+{
+	const u8 *ip = src;
+	u32 block;
+	int ret;
+
+	while (end - ip >= 4) {
+		block = get_unaligned_le32(ip);
+		if (block == LZ4F_MAGIC || block == LZ4F_LEGACY_MAGIC ||
+		    (block & LZ4F_SKIP_MASK) == LZ4F_SKIP_MAGIC)
+			break;
+		ip += 4;
+
+		/* trailing size word */
+		if (ip == end && block == (size_t)(*opp - out))
+			break;
+
+		if ((size_t)(end - ip) < block)
+			return -EINVAL;
+		ret = lz4_block(ip, block, *opp, opp,
+				min(oend, *opp + LZ4F_LEGACY_BLOCK));
+		if (ret)
+			return ret;
+		ip += block;
+	}
+
+	return ip - src;
+}
+
+int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	const u8 *ip = src, *end = ip + srcn;
+	u8 *op = dst, *oend = op + *dstn;
+	int frames = 0;
+	u32 magic;
+	int ret = 0;
+
+	perf_start(PERF_LZ4);
+
+	while (end - ip >= 4) {
+		magic = get_unaligned_le32(ip);
+		ip += 4;
+
+		if (magic == LZ4F_MAGIC) {
+			ret = lz4_frame(ip, end, &op, oend);
+		} else if (magic == LZ4F_LEGACY_MAGIC) {
+			ret = lz4_legacy_frame(ip, end, dst, &op, oend);
+		} else if ((magic & LZ4F_SKIP_MASK) == LZ4F_SKIP_MAGIC) {
+			if (end - ip < 4 ||
+			    get_unaligned_le32(ip) > (size_t)(end - ip - 4)) {
+				ret = -EINVAL;
+				break;
+			}
+			ret = 4 + get_unaligned_le32(ip);
+		} else {
+			/* ignore padding after the last frame */
+			if (!frames)
+				ret = -EPROTONOSUPPORT;
+			break;
+		}
+		if (ret < 0)
+			break;
+
+		ip += ret;
+		ret = 0;
+		frames++;
+	}
+
+	if (!frames && !ret)
+		ret = -EINVAL;
+
+	*dstn = op - (u8 *)dst;
+	perf_stop(PERF_LZ4);
+
+	return ret;
+}
@@ -0,0 +1,380 @@
+/*
+ *  LZO1X Decompressor from MiniLZO
+ *
+ *  Copyright (C) 1996-2005 Markus F.X.J. Oberhumer <markus@oberhumer.com>
+ *
+ *  The full LZO package can be found at:
+ *  http://www.oberhumer.com/opensource/lzo/
+ *
+ *  Changed for kernel use by:
+ *  Nitin Gupta <nitingupta910@gmail.com>
+ *  Richard Purdie <rpurdie@openedhand.com>
+ *
+ *  Changed for U-Boot:
+ *  lzop container parsing, memcpy() for literal runs and long
+ *  non-overlapping matches
+ */
+
+#include <common.h>
+#include <linux/lzo.h>
+#include <asm/byteorder.h>
+#include <asm/unaligned.h>
+#include <perf.h>
+#include "lzodefs.h"
+
+#define HAVE_IP(x, ip_end, ip) ((size_t)(ip_end - ip) < (x))
+#define HAVE_OP(x, op_end, op) ((size_t)(op_end - op) < (x))
+#define HAVE_LB(m_pos, out, op) (m_pos < out || m_pos >= op)
+
+/* below this length a plain byte loop beats a call to memcpy() */
+#define LZO_SHORT_COPY	16
+
+static const unsigned char lzop_magic[] = {
+	0x89, 0x4c, 0x5a, 0x4f, 0x00, 0x0d, 0x0a, 0x1a, 0x0a
+};
+
+#define HEADER_HAS_FILTER	0x00000800L
+
+/* block checksum flags, see lzop's conf.h */
+#define F_ADLER32_D		0x00000001L
+#define F_ADLER32_C		0x00000002L
+#define F_CRC32_D		0x00000100L
+#define F_CRC32_C		0x00000200L
+
+/*
+ * Skip the lzop file header and return a pointer to the first block, or
+ * NULL if the header is not one we understand. The header checksums are
+ * not verified; the image checksum already covers the whole file.
+ */
+static const unsigned char *parse_header(const unsigned char *src,
+					 size_t src_len, u32 *flags)
+{
+	const unsigned char *end = src + src_len;
+	u16 version;
+	int i;
+
+	/* magic, version, lib version, method, flags, mode, mtime, name len */
+	if (src_len < 9 + 2 + 2 + 1 + 4 + 4 + 4 + 1)
+		return NULL;
+
+	for (i = 0; i < ARRAY_SIZE(lzop_magic); i++)
+		if (*src++ != lzop_magic[i])
+			return NULL;
+
+	/* get version (2bytes), skip library version (2) */
+	version = get_unaligned_be16(src);
+	src += 4;
+	if (version >= 0x0940)
+		src += 2;	/* version needed to extract */
+	if (*src++ > 3)		/* method: one of the LZO1X variants */
+		return NULL;
+	if (version >= 0x0940)
+		src++;		/* level */
+
+	*flags = get_unaligned_be32(src);
+	src += 4;
+	if (*flags & HEADER_HAS_FILTER)
+		src += 4;	/* filter info */
+
+	/* skip mode and mtime_low */
+	src += 4 + 4;
+	if (version >= 0x0940)
+		src += 4;	/* skip mtime_high */
+
+	if (src >= end)
+		return NULL;
+	src += *src + 1;	/* skip the file name */
+
+	/* skip the header checksum */
+	src += 4;
+
+	return src <= end ? src : NULL;
+}
+
+int lzop_decompress(const unsigned char *src, size_t src_len,
+		    unsigned char *dst, size_t *dst_len)
+{
+	const unsigned char *end = src + src_len;
+	unsigned char *start = dst, *dst_end = dst + *dst_len;
+	u32 flags, dlen, slen;
+	size_t tmp;
+	int r = LZO_E_OK;
+
+	perf_start(PERF_LZO);
+
+	src = parse_header(src, src_len, &flags);
+	if (!src) {
+		r = LZO_E_ERROR;
+		goto out;
+	}
+
+	while (1) {
+		if (HAVE_IP(4, end, src)) {
+			r = LZO_E_INPUT_OVERRUN;
+			break;
+		}
+		/* read uncompressed block size, zero marks the end */
+		dlen = get_unaligned_be32(src);
+		src += 4;
+		if (dlen == 0)
+			break;
+
+		if (HAVE_IP(4, end, src)) {
+			r = LZO_E_INPUT_OVERRUN;
+			break;
+		}
+		slen = get_unaligned_be32(src);
+		src += 4;
+
+		/* skip the block checksums */
+		if (flags & F_ADLER32_D)
+			src += 4;
+		if (flags & F_CRC32_D)
+			src += 4;
+		if (slen < dlen) {
+			if (flags & F_ADLER32_C)
+				src += 4;
+			if (flags & F_CRC32_C)
+				src += 4;
+		}
+
+		if (src > end || HAVE_IP(slen, end, src)) {
+			r = LZO_E_INPUT_OVERRUN;
+			break;
+		}
+		if (HAVE_OP(dlen, dst_end, dst)) {
+			r = LZO_E_OUTPUT_OVERRUN;
+			break;
+		}
+
+		if (slen < dlen) {
+			/* decompress */
+			tmp = dlen;
+			r = lzo1x_decompress_safe(src, slen, dst, &tmp);
+			if (r != LZO_E_OK)
+				break;
+			if (tmp != dlen) {
+				r = LZO_E_ERROR;
+				break;
+			}
+		} else if (slen == dlen) {
+			/* block was not compressible, stored as is */
+			memcpy(dst, src, slen);
+		} else {
+			r = LZO_E_ERROR;
+			break;
+		}
+
+		src += slen;
+		dst += dlen;
+	}
+
+out:
+	*dst_len = dst - start;
+	perf_stop(PERF_LZO);
+
+	return r;
+}
+
+int lzo1x_decompress_safe(const unsigned char *in, size_t in_len,
+			  unsigned char *out, size_t *out_len)
+{
+	const unsigned char * const ip_end = in + in_len;
+	unsigned char * const op_end = out + *out_len;
+	const unsigned char *ip = in, *m_pos;
+	unsigned char *op = out;
+	size_t t;
+
+	*out_len = 0;
+
+	if (HAVE_IP(1, ip_end, ip))
+		goto input_overrun;
+
+	if (*ip > 17) {
+		t = *ip++ - 17;
+		if (t < 4)
+			goto match_next;
+		if (HAVE_OP(t, op_end, op))
+			goto output_overrun;
+		if (HAVE_IP(t + 1, ip_end, ip))
+			goto input_overrun;
+		memcpy(op, ip, t);
+		op += t;
+		ip += t;
+		goto first_literal_run;
+	}
+
+	while (ip < ip_end) {
+		t = *ip++;
+		if (t >= 16)
+			goto match;
+		if (t == 0) {
+			if (HAVE_IP(1, ip_end, ip))
+				goto input_overrun;
+			while (*ip == 0) {
+				t += 255;
+				ip++;
+				if (HAVE_IP(1, ip_end, ip))
+					goto input_overrun;
+			}
+			t += 15 + *ip++;
+		}
+		t += 3;
+		if (HAVE_OP(t, op_end, op))
+			goto output_overrun;
+		if (HAVE_IP(t + 1, ip_end, ip))
+			goto input_overrun;
+
+		if (t < LZO_SHORT_COPY) {
+			do {
+				*op++ = *ip++;
+			} while (--t > 0);
+		} else {
+			memcpy(op, ip, t);
+			op += t;
+			ip += t;
+		}
+
+first_literal_run:
+		t = *ip++;
+		if (t >= 16)
+			goto match;
+
+		if (HAVE_IP(1, ip_end, ip))
+			goto input_overrun;
+		m_pos = op - (1 + M2_MAX_OFFSET);
+		m_pos -= t >> 2;
+		m_pos -= *ip++ << 2;
+
+		if (HAVE_LB(m_pos, out, op))
+			goto lookbehind_overrun;
+		if (HAVE_OP(3, op_end, op))
+			goto output_overrun;
+
+		*op++ = *m_pos++;
+		*op++ = *m_pos++;
+		*op++ = *m_pos;
+
+		goto match_done;
+
+		do {
+match:
+			if (t >= 64) {
+				if (HAVE_IP(1, ip_end, ip))
+					goto input_overrun;
+				m_pos = op - 1;
+				m_pos -= (t >> 2) & 7;
+				m_pos -= *ip++ << 3;
+				t = (t >> 5) - 1;
+			} else if (t >= 32) {
+				t &= 31;
+				if (t == 0) {
+					if (HAVE_IP(1, ip_end, ip))
+						goto input_overrun;
+					while (*ip == 0) {
+						t += 255;
+						ip++;
+						if (HAVE_IP(1, ip_end, ip))
+							goto input_overrun;
+					}
+					t += 31 + *ip++;
+				}
+				if (HAVE_IP(2, ip_end, ip))
+					goto input_overrun;
+				m_pos = op - 1;
+				m_pos -= get_unaligned_le16(ip) >> 2;
+				ip += 2;
+			} else if (t >= 16) {
+				m_pos = op;
+				m_pos -= (t & 8) << 11;
+
+				t &= 7;
+				if (t == 0) {
+					if (HAVE_IP(1, ip_end, ip))
+						goto input_overrun;
+					while (*ip == 0) {
+						t += 255;
+						ip++;
+						if (HAVE_IP(1, ip_end, ip))
+							goto input_overrun;
+					}
+					t += 7 + *ip++;
+				}
+				if (HAVE_IP(2, ip_end, ip))
+					goto input_overrun;
+				m_pos -= get_unaligned_le16(ip) >> 2;
+				ip += 2;
+				if (m_pos == op)
+					goto eof_found;
+				m_pos -= 0x4000;
+			} else {
+				if (HAVE_IP(1, ip_end, ip))
+					goto input_overrun;
+				m_pos = op - 1;
+				m_pos -= t >> 2;
+				m_pos -= *ip++ << 2;
+
+				if (HAVE_LB(m_pos, out, op))
+					goto lookbehind_overrun;
+				if (HAVE_OP(2, op_end, op))
+					goto output_overrun;
+
+				*op++ = *m_pos++;
+				*op++ = *m_pos;
+				goto match_done;
+			}
+
+			if (HAVE_LB(m_pos, out, op))
+				goto lookbehind_overrun;
+			t += 2;
+			if (HAVE_OP(t, op_end, op))
+				goto output_overrun;
+
+			if (t >= LZO_SHORT_COPY && (size_t)(op - m_pos) >= t) {
+				memcpy(op, m_pos, t);
+				op += t;
+			} else {
+				do {
+					*op++ = *m_pos++;
+				} while (--t > 0);
+			}
+match_done:
+			t = ip[-2] & 3;
+			if (t == 0)
+				break;
+match_next:
+			if (HAVE_OP(t, op_end, op))
+				goto output_overrun;
+			if (HAVE_IP(t + 1, ip_end, ip))
+				goto input_overrun;
+
+			*op++ = *ip++;
+			if (t > 1) {
+				*op++ = *ip++;
+				if (t > 2)
+					*op++ = *ip++;
+			}
+
+			t = *ip++;
+		} while (ip < ip_end);
+	}
+
+	*out_len = op - out;
+	return LZO_E_EOF_NOT_FOUND;
+
+eof_found:
+	*out_len = op - out;
+	return (ip == ip_end ? LZO_E_OK :
+		(ip < ip_end ? LZO_E_INPUT_NOT_CONSUMED : LZO_E_INPUT_OVERRUN));
+input_overrun:
+	*out_len = op - out;
+	return LZO_E_INPUT_OVERRUN;
+
+output_overrun:
+	*out_len = op - out;
+	return LZO_E_OUTPUT_OVERRUN;
+
+lookbehind_overrun:
+	*out_len = op - out;
+	return LZO_E_LOOKBEHIND_OVERRUN;
+}
@@ -20,6 +20,7 @@
 
 #ifndef USE_HOSTCC
 #include <common.h>
+#include <perf.h>
 #endif /* USE_HOSTCC */
 #include <watchdog.h>
 #include <linux/string.h>
@@ -198,6 +199,8 @@ void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 	if (!length)
 		return;
 
+	perf_start(PERF_SHA256);
+
 	left = ctx->total[0] & 0x3F;
 	fill = 64 - left;
 
@@ -223,6 +226,8 @@ void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 
 	if (length)
 		memcpy((void *) (ctx->buffer + left), (void *) input, length);
+
+	perf_stop(PERF_SHA256);
 }
 
 static uint8_t sha256_padding[64] = {
@@ -47,3 +47,36 @@ void mdelay(unsigned long msec)
 	while (msec--)
 		udelay(1000);
 }
+
+/*
+ * Monotonic microsecond clock. Architectures with a fine grained free
+ * running counter override this; the fallback is only as good as
+ * get_timer() is.
+ */
+unsigned long long __timer_get_us(void)
+{
+	return (unsigned long long)get_timer(0) * (1000000 / CONFIG_SYS_HZ);
+}
+unsigned long long timer_get_us(void)
+	__attribute__((weak, alias("__timer_get_us")));
+
+/*
+ * Deadline based delays: instead of spinning in udelay() right after
+ * kicking off a slow operation, take a deadline, go do other work, and
+ * only wait for whatever time is left when the result is needed.
+ */
+unsigned long long timer_deadline_us(unsigned long usec)
+{
+	return timer_get_us() + usec;
+}
+
+int timer_deadline_passed(unsigned long long deadline)
+{
+	return (long long)(timer_get_us() - deadline) >= 0;
+}
+
+void udelay_until(unsigned long long deadline)
+{
+	while (!timer_deadline_passed(deadline))
+		WATCHDOG_RESET();
+}
@@ -9,3 +9,10 @@
  */
 
 void inflate_fast OF((z_streamp strm, unsigned start));
+
+/* input bytes inflate() must have available to call inflate_fast() */
+#ifdef CONFIG_ZLIB_INFFAST_ARMV7
+#define INFLATE_FAST_MIN_IN	10
+#else
+#define INFLATE_FAST_MIN_IN	6
+#endif
@@ -0,0 +1,326 @@
+/* inffast_armv7.c -- fast decoding for 32-bit ARM
+ * Copyright (C) 1995-2004 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ *
+ * Variant of inffast.c for ARMv7 (selected with CONFIG_ZLIB_INFFAST_ARMV7):
+ *
+ *  - the bit buffer is refilled branch-free to at least 24 bits, four
+ *    bytes at a time, instead of one or two bytes behind every test
+ *  - matches use memcpy()/memset(), which are the optimised assembler
+ *    versions with CONFIG_USE_ARCH_MEMCPY/MEMSET
+ *  - short-distance overlapping matches are expanded by doubling the
+ *    copied pattern rather than byte by byte
+ *
+ * U-Boot runs with alignment checking enabled, so all loads of the input
+ * stream are byte loads; the wide refill only saves the branches. The
+ * refill reads up to four bytes ahead of what it consumes, so inflate()
+ * must provide INFLATE_FAST_MIN_IN bytes of input instead of six.
+ */
+
+/* U-boot: we already included these
+#include "zutil.h"
+#include "inftrees.h"
+#include "inflate.h"
+#include "inffast.h"
+*/
+
+#ifndef ASMINF
+
+/* below this length a plain byte loop beats a call to memcpy() */
+#define INFFAST_SHORT_COPY	16
+
+/*
+ * Top hold up to 24..31 valid bits. Bytes loaded beyond the ones counted
+ * in bits are the following stream bytes at their correct position, so
+ * or-ing them in again on the next refill is harmless.
+ */
+#define REFILL() \
+    do { \
+        hold |= ((unsigned long)in[0] | ((unsigned long)in[1] << 8) | \
+                 ((unsigned long)in[2] << 16) | \
+                 ((unsigned long)in[3] << 24)) << bits; \
+        in += (31 - bits) >> 3; \
+        bits |= 24; \
+    } while (0)
+
+/* Copy len bytes between non-overlapping buffers */
+local unsigned char FAR *inflate_copy(unsigned char FAR *out,
+                                      const unsigned char FAR *from,
+                                      unsigned len)
+{
+    if (len < INFFAST_SHORT_COPY) {
+        while (len--)
+            *out++ = *from++;
+        return out;
+    }
+    zmemcpy(out, from, len);
+    return out + len;
+}
+
+/*
+ * Copy a match of len bytes from dist bytes back in the output. When
+ * dist < len, the source overlaps the destination and the first dist
+ * bytes repeat; each memcpy() then doubles the copied pattern.
+ */
+local unsigned char FAR *inflate_copy_match(unsigned char FAR *out,
+                                            unsigned dist, unsigned len)
+{
+    unsigned char FAR *from = out - dist;
+
+    if (len < INFFAST_SHORT_COPY) {
+        while (len > 2) {
+            *out++ = *from++;
+            *out++ = *from++;
+            *out++ = *from++;
+            len -= 3;
+        }
+        while (len--)
+            *out++ = *from++;
+        return out;
+    }
+
+    if (dist == 1) {
+        memset(out, *from, len);
+        return out + len;
+    }
+
+    while (dist < len) {
+        zmemcpy(out, from, dist);
+        out += dist;
+        len -= dist;
+        dist <<= 1;
+    }
+    zmemcpy(out, from, len);
+    return out + len;
+}
+
+/*
+   Decode literal, length, and distance codes and write out the resulting
+   literal and match bytes until either not enough input or output is
+   available, an end-of-block is encountered, or a data error is encountered.
+
+   Entry assumptions:
+
+        state->mode == LEN
+        strm->avail_in >= INFLATE_FAST_MIN_IN
+        strm->avail_out >= 258
+        start >= strm->avail_out
+        state->bits < 8
+
+   On return, state->mode is one of:
+
+        LEN -- ran out of enough output space or enough available input
+        TYPE -- reached end of block code, inflate() to interpret next block
+        BAD -- error in block data
+
+   Notes:
+
+    - One length/distance pair refills the bit buffer at most three times,
+      each refill consuming at most three bytes and looking at four, so
+      no more than ten bytes past the start of an iteration are read.
+
+    - The maximum bytes that a single length/distance pair can output is 258
+      bytes, which is the maximum length that can be coded.
+ */
+void inflate_fast(z_streamp strm, unsigned start)
+/* start: inflate()'s starting value for strm->avail_out */
+{
+    struct inflate_state FAR *state;
+    unsigned char FAR *in;      /* local strm->next_in */
+    unsigned char FAR *last;    /* while in < last, enough input available */
+    unsigned char FAR *out;     /* local strm->next_out */
+    unsigned char FAR *beg;     /* inflate()'s initial strm->next_out */
+    unsigned char FAR *end;     /* while out < end, enough space available */
+#ifdef INFLATE_STRICT
+    unsigned dmax;              /* maximum distance from zlib header */
+#endif
+    unsigned wsize;             /* window size or zero if not using window */
+    unsigned whave;             /* valid bytes in the window */
+    unsigned write;             /* window write index */
+    unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
+    unsigned long hold;         /* local strm->hold */
+    unsigned bits;              /* local strm->bits */
+    code const FAR *lcode;      /* local strm->lencode */
+    code const FAR *dcode;      /* local strm->distcode */
+    unsigned lmask;             /* mask for first level of length codes */
+    unsigned dmask;             /* mask for first level of distance codes */
+    code this;                  /* retrieved table entry */
+    unsigned op;                /* code bits, operation, extra bits, or */
+                                /*  window position, window bytes to copy */
+    unsigned len;               /* match length, unused bytes */
+    unsigned dist;              /* match distance */
+    unsigned char FAR *from;    /* where to copy match from */
+
+    /* copy state to local variables */
+    state = (struct inflate_state FAR *)strm->state;
+    in = strm->next_in;
+    last = in + (strm->avail_in - (INFLATE_FAST_MIN_IN - 1));
+    if (in > last && strm->avail_in > INFLATE_FAST_MIN_IN - 1) {
+        /*
+         * overflow detected, limit strm->avail_in to the
+         * max. possible size and recalculate last
+         */
+        strm->avail_in = 0xffffffff - (uintptr_t)in;
+        last = in + (strm->avail_in - (INFLATE_FAST_MIN_IN - 1));
+    }
+    out = strm->next_out;
+    beg = out - (start - strm->avail_out);
+    end = out + (strm->avail_out - 257);
+#ifdef INFLATE_STRICT
+    dmax = state->dmax;
+#endif
+    wsize = state->wsize;
+    whave = state->whave;
+    write = state->write;
+    window = state->window;
+    hold = state->hold;
+    bits = state->bits;
+    lcode = state->lencode;
+    dcode = state->distcode;
+    lmask = (1U << state->lenbits) - 1;
+    dmask = (1U << state->distbits) - 1;
+
+    /* decode literals and length/distances until end-of-block or not enough
+       input data or output space */
+    do {
+        REFILL();
+        this = lcode[hold & lmask];
+      dolen:
+        op = (unsigned)(this.bits);
+        hold >>= op;
+        bits -= op;
+        op = (unsigned)(this.op);
+        if (op == 0) {                          /* literal */
+            Tracevv((stderr, this.val >= 0x20 && this.val < 0x7f ?
+                    "inflate:         literal '%c'\n" :
+                    "inflate:         literal 0x%02x\n", this.val));
+            *out++ = (unsigned char)(this.val);
+        }
+        else if (op & 16) {                     /* length base */
+            len = (unsigned)(this.val);
+            op &= 15;                           /* number of extra bits */
+            if (op) {
+                /* at most 15 + 5 bits used since the refill */
+                len += (unsigned)hold & ((1U << op) - 1);
+                hold >>= op;
+                bits -= op;
+            }
+            Tracevv((stderr, "inflate:         length %u\n", len));
+            REFILL();
+            this = dcode[hold & dmask];
+          dodist:
+            op = (unsigned)(this.bits);
+            hold >>= op;
+            bits -= op;
+            op = (unsigned)(this.op);
+            if (op & 16) {                      /* distance base */
+                dist = (unsigned)(this.val);
+                op &= 15;                       /* number of extra bits */
+                if (bits < op)
+                    REFILL();
+                dist += (unsigned)hold & ((1U << op) - 1);
+#ifdef INFLATE_STRICT
+                if (dist > dmax) {
+                    strm->msg = (char *)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                hold >>= op;
+                bits -= op;
+                Tracevv((stderr, "inflate:         distance %u\n", dist));
+                op = (unsigned)(out - beg);     /* max distance in output */
+                if (dist > op) {                /* see if copy from window */
+                    op = dist - op;             /* distance back in window */
+                    if (op > whave) {
+                        strm->msg = (char *)"invalid distance too far back";
+                        state->mode = BAD;
+                        break;
+                    }
+                    from = window;
+                    if (write == 0) {           /* very common case */
+                        from += wsize - op;
+                        if (op < len) {         /* some from window */
+                            len -= op;
+                            out = inflate_copy(out, from, op);
+                            op = 0;
+                        }
+                    }
+                    else if (write < op) {      /* wrap around window */
+                        from += wsize + write - op;
+                        op -= write;
+                        if (op < len) {         /* some from end of window */
+                            len -= op;
+                            out = inflate_copy(out, from, op);
+                            from = window;
+                            op = write;
+                            if (op < len) {     /* some from start of window */
+                                len -= op;
+                                out = inflate_copy(out, from, op);
+                                op = 0;
+                            }
+                        }
+                    }
+                    else {                      /* contiguous in window */
+                        from += write - op;
+                        if (op < len) {         /* some from window */
+                            len -= op;
+                            out = inflate_copy(out, from, op);
+                            op = 0;
+                        }
+                    }
+                    if (op)                     /* all of it in the window */
+                        out = inflate_copy(out, from, len);
+                    else                        /* rest from output */
+                        out = inflate_copy_match(out, dist, len);
+                }
+                else {
+                    out = inflate_copy_match(out, dist, len);
+                }
+            }
+            else if ((op & 64) == 0) {          /* 2nd level distance code */
+                this = dcode[this.val + (hold & ((1U << op) - 1))];
+                goto dodist;
+            }
+            else {
+                strm->msg = (char *)"invalid distance code";
+                state->mode = BAD;
+                break;
+            }
+        }
+        else if ((op & 64) == 0) {              /* 2nd level length code */
+            this = lcode[this.val + (hold & ((1U << op) - 1))];
+            goto dolen;
+        }
+        else if (op & 32) {                     /* end-of-block */
+            Tracevv((stderr, "inflate:         end of block\n"));
+            state->mode = TYPE;
+            break;
+        }
+        else {
+            strm->msg = (char *)"invalid literal/length code";
+            state->mode = BAD;
+            break;
+        }
+    } while (in < last && out < end);
+
+    /* return unused bytes (on entry, bits < 8, so in won't go too far back) */
+    len = bits >> 3;
+    in -= len;
+    bits -= len << 3;
+    hold &= (1U << bits) - 1;
+
+    /* update state and return */
+    strm->next_in = in;
+    strm->next_out = out;
+    strm->avail_in = (unsigned)(in < last ?
+                                (INFLATE_FAST_MIN_IN - 1) + (last - in) :
+                                (INFLATE_FAST_MIN_IN - 1) - (in - last));
+    strm->avail_out = (unsigned)(out < end ?
+                                 257 + (end - out) : 257 - (out - end));
+    state->hold = hold;
+    state->bits = bits;
+    return;
+}
+
+#endif /* !ASMINF */
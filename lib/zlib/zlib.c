@@ -25,7 +25,11 @@
 #include "inflate.h"
 #include "inffast.h"
 #include "inffixed.h"
+#ifdef CONFIG_ZLIB_INFFAST_ARMV7
+#include "inffast_armv7.c"
+#else
 #include "inffast.c"
+#endif
 #include "inftrees.c"
 #include "inflate.c"
 #include "zutil.c"
@@ -84,6 +84,7 @@
 #include <command.h>
 #include <environment.h>
 #include <net.h>
+#include <perf.h>
 #if defined(CONFIG_STATUS_LED)
 #include <miiphy.h>
 #include <status_led.h>
@@ -936,8 +937,8 @@ static void receive_icmp(struct ip_udp_hdr *ip, int len,
 	}
 }
 
-void
-NetReceive(uchar *inpkt, int len)
+static void
+net_receive(uchar *inpkt, int len)
 {
 	struct ethernet_hdr *et;
 	struct ip_udp_hdr *ip;
@@ -1189,6 +1190,14 @@ NetReceive(uchar *inpkt, int len)
 	}
 }
 
+void
+NetReceive(uchar *inpkt, int len)
+{
+	perf_start(PERF_NET_RECEIVE);
+	net_receive(inpkt, len);
+	perf_stop(PERF_NET_RECEIVE);
+}
+
 
 /**********************************************************************/
 
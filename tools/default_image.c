@@ -105,10 +105,8 @@ static void image_set_header(void *ptr, struct stat *sbuf, int ifd,
 
 	image_header_t * hdr = (image_header_t *)ptr;
 
-	checksum = crc32(0,
-			(const unsigned char *)(ptr +
-				sizeof(image_header_t)),
-			sbuf->st_size - sizeof(image_header_t));
+	/* data CRC was computed by mkimage while copying the data files */
+	checksum = params->dcrc;
 
 	/* Build new header */
 	image_set_magic(hdr, IH_MAGIC);
@@ -142,6 +140,7 @@ static struct image_type_params defimage_params = {
 	.print_header = image_print_contents,
 	.set_header = image_set_header,
 	.check_params = image_check_params,
+	.stream_dcrc = 1,
 };
 
 void init_default_image_type(void)
@@ -35,6 +35,7 @@
 #include <sys/types.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <unistd.h>
 
 #ifdef MTD_OLD
@@ -114,6 +115,31 @@ static struct environment environment = {
 	.flag_scheme = FLAG_NONE,
 };
 
+/*
+ * Hash index over the environment, built while a batch of updates is
+ * applied. Entries keep the order of the flat blob; setting a variable
+ * marks its old entry deleted and appends a new one, which leaves the
+ * blob in exactly the state the sequential fw_env_write() produces.
+ */
+struct env_entry_s {
+	char		*str;		/* "name=value" */
+	int		namelen;	/* -1 for strings without '=' */
+	int		deleted;
+	int		alloced;	/* str was malloc()ed */
+};
+
+struct env_index_s {
+	char			*copy;	/* blob the original entries live in */
+	struct env_entry_s	*entries;
+	int			count;
+	int			size;
+	int			*table;	/* entry number + 1, 0 if free */
+	unsigned int		mask;
+	size_t			used;	/* bytes taken in the flat blob */
+};
+
+static struct env_index_s *env_index;
+
 static int HaveRedundEnv = 0;
 
 static unsigned char active_flag = 1;
@@ -125,6 +151,10 @@ static unsigned char obsolete_flag = 0;
 
 static int flash_io (int mode);
 static char *envmatch (char * s1, char * s2);
+static int fw_env_index_build(void);
+static char *fw_env_index_get(char *name);
+static int fw_env_index_write(char *name, char *value);
+static void fw_env_index_flush(void);
 static int parse_config (void);
 
 #if defined(CONFIG_FILE)
@@ -163,6 +193,9 @@ char *fw_getenv (char *name)
 {
 	char *env, *nxt;
 
+	if (env_index)
+		return fw_env_index_get(name);
+
 	for (env = environment.data; *env; env = nxt + 1) {
 		char *val;
 
@@ -248,30 +281,22 @@ int fw_printenv (int argc, char *argv[])
 		n_flag = 0;
 	}
 
+	/* Index the environment once if several names are looked up */
+	if (argc > 2 && fw_env_index_build())
+		return -1;
+
 	for (i = 1; i < argc; ++i) {	/* print single env variables   */
 		char *name = argv[i];
-		char *val = NULL;
-
-		for (env = environment.data; *env; env = nxt + 1) {
+		char *val;
 
-			for (nxt = env; *nxt; ++nxt) {
-				if (nxt >= &environment.data[ENV_SIZE]) {
-					fprintf (stderr, "## Error: "
-						"environment not terminated\n");
-					return -1;
-				}
-			}
-			val = envmatch (name, env);
-			if (val) {
-				if (!n_flag) {
-					fputs (name, stdout);
-					putc ('=', stdout);
-				}
-				puts (val);
-				break;
+		val = fw_getenv (name);
+		if (val) {
+			if (!n_flag) {
+				fputs (name, stdout);
+				putc ('=', stdout);
 			}
-		}
-		if (!val) {
+			puts (val);
+		} else {
 			fprintf (stderr, "## Error: \"%s\" not defined\n", name);
 			rc = -1;
 		}
@@ -282,6 +307,10 @@ int fw_printenv (int argc, char *argv[])
 
 int fw_env_close(void)
 {
+	/* Write back a batch of indexed updates */
+	if (env_index)
+		fw_env_index_flush();
+
 	/*
 	 * Update CRC
 	 */
@@ -299,33 +328,14 @@ int fw_env_close(void)
 
 
 /*
- * Set/Clear a single variable in the environment.
- * This is called in sequence to update the environment
- * in RAM without updating the copy in flash after each set
+ * Check whether "name" may be changed from "oldval" to "value".
+ * Returns 0 if the change may go ahead, 1 if there is nothing to do and
+ * -1 (with errno set) if the change is not permitted.
  */
-int fw_env_write(char *name, char *value)
+static int fw_env_check_access(char *name, char *oldval, char *value)
 {
-	int len;
-	char *env, *nxt;
-	char *oldval = NULL;
 	int deleting, creating, overwriting;
 
-	/*
-	 * search if variable with this name already exists
-	 */
-	for (nxt = env = environment.data; *env; env = nxt + 1) {
-		for (nxt = env; *nxt; ++nxt) {
-			if (nxt >= &environment.data[ENV_SIZE]) {
-				fprintf(stderr, "## Error: "
-					"environment not terminated\n");
-				errno = EINVAL;
-				return -1;
-			}
-		}
-		if ((oldval = envmatch (name, env)) != NULL)
-			break;
-	}
-
 	deleting = (oldval && !(value && strlen(value)));
 	creating = (!oldval && (value && strlen(value)));
 	overwriting = (oldval && (value && strlen(value)));
@@ -366,9 +376,47 @@ int fw_env_write(char *name, char *value)
 		}
 	} else
 		/* Nothing to do */
-		return 0;
+		return 1;
+
+	return 0;
+}
+
+/*
+ * Set/Clear a single variable in the environment.
+ * This is called in sequence to update the environment
+ * in RAM without updating the copy in flash after each set
+ */
+int fw_env_write(char *name, char *value)
+{
+	int len;
+	char *env, *nxt;
+	char *oldval = NULL;
+	int ret;
+
+	if (env_index)
+		return fw_env_index_write(name, value);
+
+	/*
+	 * search if variable with this name already exists
+	 */
+	for (nxt = env = environment.data; *env; env = nxt + 1) {
+		for (nxt = env; *nxt; ++nxt) {
+			if (nxt >= &environment.data[ENV_SIZE]) {
+				fprintf(stderr, "## Error: "
+					"environment not terminated\n");
+				errno = EINVAL;
+				return -1;
+			}
+		}
+		if ((oldval = envmatch (name, env)) != NULL)
+			break;
+	}
 
-	if (deleting || overwriting) {
+	ret = fw_env_check_access(name, oldval, value);
+	if (ret)
+		return ret < 0 ? -1 : 0;
+
+	if (oldval) {
 		if (*++nxt == '\0') {
 			*env = '\0';
 		} else {
@@ -477,47 +525,16 @@ int fw_setenv(int argc, char *argv[])
 }
 
 /*
- * Parse  a file  and configure the u-boot variables.
- * The script file has a very simple format, as follows:
- *
- * Each line has a couple with name, value:
- * <white spaces>variable_name<white spaces>variable_value
- *
- * Both variable_name and variable_value are interpreted as strings.
- * Any character after <white spaces> and before ending \r\n is interpreted
- * as variable's value (no comment allowed on these lines !)
- *
- * Comments are allowed if the first character in the line is #
- *
- * Returns -1 and sets errno error codes:
- * 0	  - OK
- * -1     - Error
+ * Apply the "name value" lines read from fp to the environment in RAM.
+ * Returns 0 on success, -1 on the first error.
  */
-int fw_parse_script(char *fname)
+static int fw_env_apply_script(FILE *fp)
 {
-	FILE *fp;
 	char dump[1024];	/* Maximum line length in the file */
 	char *name;
 	char *val;
 	int lineno = 0;
 	int len;
-	int ret = 0;
-
-	if (fw_env_open()) {
-		fprintf(stderr, "Error: environment not initialized\n");
-		return -1;
-	}
-
-	if (strcmp(fname, "-") == 0)
-		fp = stdin;
-	else {
-		fp = fopen(fname, "r");
-		if (fp == NULL) {
-			fprintf(stderr, "I cannot open %s for reading\n",
-				 fname);
-			return -1;
-		}
-	}
 
 	while (fgets(dump, sizeof(dump), fp)) {
 		lineno++;
@@ -531,8 +548,7 @@ int fw_parse_script(char *fname)
 			fprintf(stderr,
 			"Line %d not corrected terminated or too long\n",
 				lineno);
-			ret = -1;
-			break;
+			return -1;
 		}
 
 		/* Drop ending line feed / carriage return */
@@ -570,10 +586,8 @@ int fw_parse_script(char *fname)
 			name, val ? val : " removed");
 #endif
 
-		if (env_flags_validate_type(name, val) < 0) {
-			ret = -1;
-			break;
-		}
+		if (env_flags_validate_type(name, val) < 0)
+			return -1;
 
 		/*
 		 * If there is an error setting a variable,
@@ -583,12 +597,59 @@ int fw_parse_script(char *fname)
 			fprintf(stderr,
 			"fw_env_write returns with error : %s\n",
 				strerror(errno));
-			ret = -1;
-			break;
+			return -1;
 		}
+	}
+
+	return 0;
+}
+
+/*
+ * Parse  a file  and configure the u-boot variables.
+ * The script file has a very simple format, as follows:
+ *
+ * Each line has a couple with name, value:
+ * <white spaces>variable_name<white spaces>variable_value
+ *
+ * Both variable_name and variable_value are interpreted as strings.
+ * Any character after <white spaces> and before ending \r\n is interpreted
+ * as variable's value (no comment allowed on these lines !)
+ *
+ * Comments are allowed if the first character in the line is #
+ *
+ * The whole script is applied as one batch: the environment is indexed
+ * once, and written back with a single CRC update and flash write.
+ *
+ * Returns -1 and sets errno error codes:
+ * 0	  - OK
+ * -1     - Error
+ */
+int fw_parse_script(char *fname)
+{
+	FILE *fp;
+	int ret = 0;
 
+	if (fw_env_open()) {
+		fprintf(stderr, "Error: environment not initialized\n");
+		return -1;
 	}
 
+	if (strcmp(fname, "-") == 0)
+		fp = stdin;
+	else {
+		fp = fopen(fname, "r");
+		if (fp == NULL) {
+			fprintf(stderr, "I cannot open %s for reading\n",
+				 fname);
+			return -1;
+		}
+	}
+
+	/* without an index we simply fall back to the sequential path */
+	fw_env_index_build();
+
+	ret = fw_env_apply_script(fp);
+
 	/* Close file if not stdin */
 	if (strcmp(fname, "-") != 0)
 		fclose(fp);
@@ -599,6 +660,401 @@ int fw_parse_script(char *fname)
 
 }
 
+/*
+ * Read a whole script file (or stdin for "-") into memory.
+ */
+static char *fw_read_script(char *fname, size_t *lenp)
+{
+	FILE *fp;
+	char *buf = NULL;
+	size_t len = 0, size = 0, n;
+
+	if (strcmp(fname, "-") == 0)
+		fp = stdin;
+	else {
+		fp = fopen(fname, "r");
+		if (fp == NULL) {
+			fprintf(stderr, "I cannot open %s for reading\n",
+				 fname);
+			return NULL;
+		}
+	}
+
+	do {
+		if (len == size) {
+			size = size ? size * 2 : 4096;
+			buf = realloc(buf, size);
+			if (!buf) {
+				fprintf(stderr, "Cannot malloc %zu bytes\n",
+					size);
+				break;
+			}
+		}
+		n = fread(buf + len, 1, size - len, fp);
+		len += n;
+	} while (n);
+
+	if (strcmp(fname, "-") != 0)
+		fclose(fp);
+
+	*lenp = len;
+	return buf;
+}
+
+/* Length of the flat blob up to and including the terminating "\0\0" */
+static size_t fw_env_blob_len(const char *data)
+{
+	const char *p = data;
+
+	while (*p || *(p + 1))
+		p++;
+	return p - data + 2;
+}
+
+static long fw_elapsed_us(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) * 1000000L +
+	       (now.tv_usec - start->tv_usec);
+}
+
+/*
+ * Apply a script twice to the environment in RAM, once variable by
+ * variable and once through the index, and report the time taken by
+ * each. Flash is not written.
+ */
+int fw_env_benchmark(char *fname)
+{
+	char *script, *orig, *seq;
+	struct timeval start;
+	long t_seq, t_idx;
+	size_t len, seq_len, idx_len;
+	FILE *fp;
+	int ret_seq, ret_idx;
+	int ret = -1;
+
+	if (fw_env_open()) {
+		fprintf(stderr, "Error: environment not initialized\n");
+		return -1;
+	}
+
+	script = fw_read_script(fname, &len);
+	if (!script)
+		return -1;
+	if (!len) {
+		fprintf(stderr, "Error: empty script\n");
+		goto out_script;
+	}
+
+	orig = malloc(ENV_SIZE);
+	seq = malloc(ENV_SIZE);
+	if (!orig || !seq) {
+		fprintf(stderr, "Cannot malloc %lu bytes\n", ENV_SIZE);
+		goto out;
+	}
+	memcpy(orig, environment.data, ENV_SIZE);
+
+	fp = fmemopen(script, len, "r");
+	if (!fp)
+		goto out_fmemopen;
+	gettimeofday(&start, NULL);
+	ret_seq = fw_env_apply_script(fp);
+	t_seq = fw_elapsed_us(&start);
+	fclose(fp);
+
+	memcpy(seq, environment.data, ENV_SIZE);
+	memcpy(environment.data, orig, ENV_SIZE);
+
+	fp = fmemopen(script, len, "r");
+	if (!fp)
+		goto out_fmemopen;
+	gettimeofday(&start, NULL);
+	ret_idx = fw_env_index_build();
+	if (!ret_idx)
+		ret_idx = fw_env_apply_script(fp);
+	if (env_index)
+		fw_env_index_flush();
+	t_idx = fw_elapsed_us(&start);
+	fclose(fp);
+
+	seq_len = fw_env_blob_len(seq);
+	idx_len = fw_env_blob_len(environment.data);
+
+	printf("sequential: %ld us\n", t_seq);
+	printf("indexed:    %ld us\n", t_idx);
+
+	if (ret_seq != ret_idx || seq_len != idx_len ||
+	    memcmp(seq, environment.data, seq_len)) {
+		fprintf(stderr, "Error: results differ\n");
+		goto out;
+	}
+	printf("results identical (%zu bytes)\n", idx_len);
+	ret = 0;
+	goto out;
+
+out_fmemopen:
+	fprintf(stderr, "Cannot open script buffer: %s\n", strerror(errno));
+out:
+	free(seq);
+	free(orig);
+out_script:
+	free(script);
+	return ret;
+}
+
+static unsigned int fw_env_hash(const char *name, int len)
+{
+	unsigned int hash = 5381;
+
+	while (len--)
+		hash = hash * 33 + (unsigned char)*name++;
+	return hash;
+}
+
+/*
+ * Return the table slot holding "name", or the free slot it would go
+ * in. Deleted entries keep their slot so that re-setting the variable
+ * finds it again.
+ */
+static int *fw_env_index_slot(const char *name, int len)
+{
+	unsigned int i = fw_env_hash(name, len) & env_index->mask;
+	struct env_entry_s *e;
+
+	for (;; i = (i + 1) & env_index->mask) {
+		if (!env_index->table[i])
+			return &env_index->table[i];
+		e = &env_index->entries[env_index->table[i] - 1];
+		if (e->namelen == len && !memcmp(e->str, name, len))
+			return &env_index->table[i];
+	}
+}
+
+static int fw_env_index_grow(void)
+{
+	struct env_entry_s *entries;
+	unsigned int size, i;
+	int *old = env_index->table;
+	unsigned int old_size = old ? env_index->mask + 1 : 0;
+
+	if (env_index->count == env_index->size) {
+		size = env_index->size ? env_index->size * 2 : 256;
+		entries = realloc(env_index->entries, size * sizeof(*entries));
+		if (!entries)
+			return -1;
+		env_index->entries = entries;
+		env_index->size = size;
+	}
+
+	/* Keep the hash table at most half full */
+	if (2 * (env_index->count + 1) <= old_size)
+		return 0;
+
+	size = old_size ? old_size * 2 : 512;
+	env_index->table = calloc(size, sizeof(int));
+	if (!env_index->table) {
+		env_index->table = old;
+		return -1;
+	}
+	env_index->mask = size - 1;
+
+	for (i = 0; i < old_size; i++) {
+		struct env_entry_s *e;
+
+		if (!old[i])
+			continue;
+		e = &env_index->entries[old[i] - 1];
+		*fw_env_index_slot(e->str, e->namelen) = old[i];
+	}
+	free(old);
+
+	return 0;
+}
+
+/* Append a "name=value" string; it is not hashed if it has no '=' */
+static int fw_env_index_add(char *str, int alloced)
+{
+	struct env_entry_s *e;
+	char *eq;
+	int *slot = NULL;
+
+	if (fw_env_index_grow())
+		return -1;
+
+	e = &env_index->entries[env_index->count];
+	e->str = str;
+	e->deleted = 0;
+	e->alloced = alloced;
+	eq = strchr(str, '=');
+	e->namelen = eq ? eq - str : -1;
+
+	if (eq) {
+		slot = fw_env_index_slot(str, e->namelen);
+		/* Like envmatch(), a lookup finds the first definition */
+		if (!*slot || alloced)
+			*slot = env_index->count + 1;
+	}
+
+	env_index->count++;
+	env_index->used += strlen(str) + 1;
+
+	return 0;
+}
+
+static void fw_env_index_free(void)
+{
+	int i;
+
+	for (i = 0; i < env_index->count; i++)
+		if (env_index->entries[i].alloced)
+			free(env_index->entries[i].str);
+	free(env_index->entries);
+	free(env_index->table);
+	free(env_index->copy);
+	free(env_index);
+	env_index = NULL;
+}
+
+/*
+ * Index the environment currently in RAM. Until fw_env_close() (or
+ * fw_env_index_flush()) writes it back, lookups and updates go through
+ * the index instead of scanning the blob.
+ */
+static int fw_env_index_build(void)
+{
+	char *env, *nxt;
+
+	if (env_index)
+		return 0;
+
+	env_index = calloc(1, sizeof(*env_index));
+	if (!env_index)
+		goto err_nomem;
+
+	env_index->copy = malloc(ENV_SIZE);
+	if (!env_index->copy)
+		goto err_nomem;
+	memcpy(env_index->copy, environment.data, ENV_SIZE);
+
+	/* Allocate the table up front, an empty environment adds nothing */
+	if (fw_env_index_grow())
+		goto err_nomem;
+
+	for (env = env_index->copy; *env; env = nxt + 1) {
+		for (nxt = env; *nxt; ++nxt) {
+			if (nxt >= &env_index->copy[ENV_SIZE]) {
+				fprintf(stderr, "## Error: "
+					"environment not terminated\n");
+				fw_env_index_free();
+				errno = EINVAL;
+				return -1;
+			}
+		}
+		if (fw_env_index_add(env, 0))
+			goto err_nomem;
+	}
+
+	return 0;
+
+err_nomem:
+	fprintf(stderr, "Not enough memory for environment index\n");
+	if (env_index)
+		fw_env_index_free();
+	errno = ENOMEM;
+	return -1;
+}
+
+static char *fw_env_index_get(char *name)
+{
+	struct env_entry_s *e;
+	int slot;
+
+	slot = *fw_env_index_slot(name, strlen(name));
+	if (!slot)
+		return NULL;
+
+	e = &env_index->entries[slot - 1];
+	return e->deleted ? NULL : e->str + e->namelen + 1;
+}
+
+/* fw_env_write() on the index; same checks and same resulting blob */
+static int fw_env_index_write(char *name, char *value)
+{
+	struct env_entry_s *e = NULL;
+	char *oldval = NULL;
+	char *str;
+	int slot, len, ret;
+
+	slot = *fw_env_index_slot(name, strlen(name));
+	if (slot) {
+		e = &env_index->entries[slot - 1];
+		if (!e->deleted)
+			oldval = e->str + e->namelen + 1;
+	}
+
+	ret = fw_env_check_access(name, oldval, value);
+	if (ret)
+		return ret < 0 ? -1 : 0;
+
+	if (oldval) {
+		e->deleted = 1;
+		env_index->used -= strlen(e->str) + 1;
+	}
+
+	/* Delete only ? */
+	if (!value || !strlen(value))
+		return 0;
+
+	/* "name" + "=" + "val" +"\0\0" must fit behind the used part */
+	len = strlen(name) + 2 + strlen(value) + 1;
+	if (len > ENV_SIZE - env_index->used) {
+		fprintf (stderr,
+			"Error: environment overflow, \"%s\" deleted\n",
+			name);
+		return -1;
+	}
+
+	str = malloc(len - 1);
+	if (!str) {
+		errno = ENOMEM;
+		return -1;
+	}
+	sprintf(str, "%s=%s", name, value);
+
+	if (fw_env_index_add(str, 1)) {
+		free(str);
+		errno = ENOMEM;
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Write the indexed environment back to the flat blob and drop the index */
+static void fw_env_index_flush(void)
+{
+	char *env = environment.data;
+	size_t len;
+	int i;
+
+	for (i = 0; i < env_index->count; i++) {
+		struct env_entry_s *e = &env_index->entries[i];
+
+		if (e->deleted)
+			continue;
+		len = strlen(e->str) + 1;
+		memcpy(env, e->str, len);
+		env += len;
+	}
+
+	/* end is marked with double '\0' */
+	memset(env, 0, &environment.data[ENV_SIZE] - env);
+
+	fw_env_index_free();
+}
+
 /*
  * Test for bad block on NAND, just returns 0 on NOR, on NAND:
  * 0	- block is good
@@ -36,7 +36,9 @@
  * See included "fw_env.config" sample file
  * for notes on configuration.
  */
+#ifndef CONFIG_FILE
 #define CONFIG_FILE     "/etc/fw_env.config"
+#endif
 
 #ifndef CONFIG_FILE
 #define HAVE_REDUND /* For systems with 2 env sectors */
@@ -72,6 +74,7 @@ extern int   fw_printenv(int argc, char *argv[]);
 extern char *fw_getenv  (char *name);
 extern int fw_setenv  (int argc, char *argv[]);
 extern int fw_parse_script(char *fname);
+extern int fw_env_benchmark(char *fname);
 extern int fw_env_open(void);
 extern int fw_env_write(char *name, char *value);
 extern int fw_env_close(void);
@@ -37,6 +37,11 @@
  *		  separated by single blank characters, and the
  *		  resulting string is assigned to the environment
  *		  variable "name"
+ *	fw_setenv -s [ file ]
+ *		- applies all "name value" lines of the script as one batch
+ *	fw_setenv -b [ file ]
+ *		- times the script applied variable by variable against
+ *		  the batch path, without writing the environment back
  */
 
 #include <fcntl.h>
@@ -53,6 +58,7 @@
 
 static struct option long_options[] = {
 	{"script", required_argument, NULL, 's'},
+	{"benchmark", required_argument, NULL, 'b'},
 	{"help", no_argument, NULL, 'h'},
 	{NULL, 0, NULL, 0}
 };
@@ -65,7 +71,8 @@ void usage(void)
 		"usage:\tfw_printenv [-n] [variable name]\n"
 		"\tfw_setenv [variable name] [variable value]\n"
 		"\tfw_setenv -s [ file ]\n"
-		"\tfw_setenv -s - < [ file ]\n\n"
+		"\tfw_setenv -s - < [ file ]\n"
+		"\tfw_setenv -b [ file ]\n\n"
 		"The file passed as argument contains only pairs "
 		"name / value\n"
 		"Example:\n"
@@ -81,6 +88,9 @@ void usage(void)
 		"to put any number of spaces between the fields, but any\n"
 		"space inside the value is treated as part of the value "
 		"itself.\n\n"
+		"With -b the script is applied in RAM both one variable at\n"
+		"a time and as a batch, the time taken by each is printed\n"
+		"and nothing is written back.\n\n"
 	);
 }
 
@@ -89,6 +99,7 @@ int main(int argc, char *argv[])
 	char *p;
 	char *cmdname = *argv;
 	char *script_file = NULL;
+	char *bench_file = NULL;
 	int c;
 	const char *lockname = "/var/lock/" CMD_PRINTENV ".lock";
 	int lockfd = -1;
@@ -110,7 +121,7 @@ int main(int argc, char *argv[])
 		cmdname = p + 1;
 	}
 
-	while ((c = getopt_long (argc, argv, "ns:h",
+	while ((c = getopt_long (argc, argv, "ns:b:h",
 		long_options, NULL)) != EOF) {
 		switch (c) {
 		case 'n':
@@ -119,6 +130,9 @@ int main(int argc, char *argv[])
 		case 's':
 			script_file = optarg;
 			break;
+		case 'b':
+			bench_file = optarg;
+			break;
 		case 'h':
 			usage();
 			goto exit;
@@ -134,7 +148,10 @@ int main(int argc, char *argv[])
 		if (fw_printenv(argc, argv) != 0)
 			retval = EXIT_FAILURE;
 	} else if (strcmp(cmdname, CMD_SETENV) == 0) {
-		if (!script_file) {
+		if (bench_file) {
+			if (fw_env_benchmark(bench_file) != 0)
+				retval = EXIT_FAILURE;
+		} else if (!script_file) {
 			if (fw_setenv(argc, argv) != 0)
 				retval = EXIT_FAILURE;
 		} else {
@@ -0,0 +1,66 @@
+#!/bin/sh
+#
+# Regression tests for fw_printenv/fw_setenv on a file-backed environment
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of
+# the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+# MA 02111-1307 USA
+#
+# Run from the top of a configured tree (after "make <board>_config").
+# The tool is built into a temporary directory with its configuration
+# file there as well; HOSTCC, HOSTCFLAGS and OBJTREE are honoured.
+
+SRCTREE=$(pwd)
+OBJTREE=${OBJTREE:-$SRCTREE}
+HOSTCC=${HOSTCC:-cc}
+
+tmp=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmp"' EXIT
+failed=0
+
+fail() {
+	echo "FAIL: $*"
+	failed=1
+}
+
+$HOSTCC $HOSTCFLAGS -idirafter $SRCTREE/include \
+	-idirafter $OBJTREE/include2 -idirafter $OBJTREE/include \
+	-idirafter $SRCTREE/tools/env -DUSE_HOSTCC \
+	-DCONFIG_FILE="\"$tmp/fw_env.config\"" -o $tmp/fw_printenv \
+	$SRCTREE/lib/crc32.c $SRCTREE/tools/env/fw_env.c \
+	$SRCTREE/tools/env/fw_env_main.c $SRCTREE/lib/ctype.c \
+	$SRCTREE/lib/linux_string.c $SRCTREE/common/env_attr.c \
+	$SRCTREE/common/env_flags.c || exit 1
+ln -s fw_printenv $tmp/fw_setenv
+
+# device names are limited to 15 characters, keep it relative
+cd $tmp || exit 1
+echo "env 0x0000 0x4000 0x4000" > fw_env.config
+dd if=/dev/zero of=env bs=1024 count=16 2>/dev/null
+
+# Empty environment with a valid CRC: delete all default variables
+./fw_printenv 2>/dev/null | sed 's/=.*//' > names
+./fw_setenv -s names 2>/dev/null || fail "deleting all variables"
+[ -z "$(./fw_printenv 2>&1)" ] || fail "environment not empty"
+
+./fw_printenv a b > /dev/null 2>&1
+[ $? -eq 1 ] || fail "fw_printenv of unset names in an empty environment"
+
+printf 'a 1\nb 2\n' > script
+./fw_setenv -s script || fail "fw_setenv -s on an empty environment"
+[ "$(./fw_printenv a b)" = "a=1
+b=2" ] || fail "variables set on an empty environment"
+
+[ $failed -eq 0 ] && echo "fw_env: all tests passed"
+exit $failed
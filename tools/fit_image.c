@@ -29,6 +29,7 @@
 
 #include "mkimage.h"
 #include <image.h>
+#include <sys/time.h>
 #include <u-boot/crc.h>
 
 static image_header_t header;
@@ -107,6 +108,7 @@ static int fit_handle_file (struct mkimage_params *params)
 	char cmd[MKIMAGE_MAX_DTC_CMDLINE_LEN];
 	int tfd;
 	struct stat sbuf;
+	struct timeval start, end;
 	void *ptr;
 
 	/* Flattened Image Tree (FIT) format  handling */
@@ -137,11 +139,18 @@ static int fit_handle_file (struct mkimage_params *params)
 		goto err_mmap;
 
 	/* set hashes for images in the blob */
-	if (fit_add_verification_data(ptr)) {
+	gettimeofday(&start, NULL);
+	if (fit_add_verification_data_jobs(ptr, params->jobs)) {
 		fprintf (stderr, "%s Can't add hashes to FIT blob",
 				params->cmdname);
 		goto err_add_hashes;
 	}
+	gettimeofday(&end, NULL);
+	if (params->vflag)
+		printf("Hashed FIT images in %ld ms (%d job%s)\n",
+		       (end.tv_sec - start.tv_sec) * 1000 +
+		       (end.tv_usec - start.tv_usec) / 1000,
+		       params->jobs, params->jobs == 1 ? "" : "s");
 
 	/* add a timestamp at offset 0 i.e., root  */
 	if (fit_set_timestamp (ptr, 0, sbuf.st_mtime)) {
@@ -28,6 +28,7 @@
 #include "mkimage.h"
 #include <bootstage.h>
 #include <image.h>
+#include <pthread.h>
 #include <sha1.h>
 #include <time.h>
 #include <u-boot/crc.h>
@@ -206,3 +207,206 @@ int fit_add_verification_data(void *fit)
 
 	return 0;
 }
+
+/*
+ * One hash sub-node to be computed by fit_add_verification_data_jobs().
+ * All pointers refer into the blob as it was before any value was
+ * written, which is why every message is printed before the write pass.
+ */
+struct fit_hash_job {
+	const char *image_name;
+	const char *node_name;
+	const void *data;
+	size_t size;
+	char *algo;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+	int ret;
+};
+
+struct fit_hash_queue {
+	struct fit_hash_job *jobs;
+	int count;
+	int next;
+	pthread_mutex_t lock;
+};
+
+static void *fit_hash_worker(void *arg)
+{
+	struct fit_hash_queue *queue = arg;
+	struct fit_hash_job *job;
+	int i;
+
+	for (;;) {
+		pthread_mutex_lock(&queue->lock);
+		i = queue->next++;
+		pthread_mutex_unlock(&queue->lock);
+		if (i >= queue->count)
+			break;
+
+		job = &queue->jobs[i];
+		job->ret = calculate_hash(job->data, job->size, job->algo,
+					  job->value, &job->value_len);
+	}
+
+	return NULL;
+}
+
+static int fit_is_hash_node(const void *fit, int noffset)
+{
+	return !strncmp(fit_get_name(fit, noffset, NULL), FIT_HASH_NODENAME,
+			strlen(FIT_HASH_NODENAME));
+}
+
+/*
+ * Collect all image hash sub-nodes, in the order the serial code visits
+ * them. Returns the number of jobs, or -1 on error.
+ */
+static int fit_collect_hash_jobs(void *fit, int images_noffset,
+				 struct fit_hash_job **jobsp)
+{
+	struct fit_hash_job *jobs = NULL, *job, *tmp;
+	int count = 0;
+	int image_noffset, noffset;
+	const char *image_name;
+	const void *data;
+	size_t size;
+
+	for (image_noffset = fdt_first_subnode(fit, images_noffset);
+	     image_noffset >= 0;
+	     image_noffset = fdt_next_subnode(fit, image_noffset)) {
+		if (fit_image_get_data(fit, image_noffset, &data, &size)) {
+			printf("Can't get image data/size\n");
+			goto err;
+		}
+		image_name = fit_get_name(fit, image_noffset, NULL);
+
+		for (noffset = fdt_first_subnode(fit, image_noffset);
+		     noffset >= 0;
+		     noffset = fdt_next_subnode(fit, noffset)) {
+			if (!fit_is_hash_node(fit, noffset))
+				continue;
+
+			tmp = realloc(jobs, (count + 1) * sizeof(*jobs));
+			if (!tmp) {
+				printf("Out of memory\n");
+				goto err;
+			}
+			jobs = tmp;
+			job = &jobs[count++];
+			memset(job, 0, sizeof(*job));
+			job->image_name = image_name;
+			job->node_name = fit_get_name(fit, noffset, NULL);
+			job->data = data;
+			job->size = size;
+			if (fit_image_hash_get_algo(fit, noffset, &job->algo)) {
+				printf("Can't get hash algo property for '%s' hash node in '%s' image node\n",
+				       job->node_name, image_name);
+				goto err;
+			}
+		}
+	}
+
+	*jobsp = jobs;
+	return count;
+
+err:
+	free(jobs);
+	return -1;
+}
+
+/**
+ * fit_add_verification_data_jobs() - calculate/set hashes using threads
+ *
+ * Same result as fit_add_verification_data(), but all hashes are first
+ * computed concurrently by @jobs worker threads and then written to the
+ * blob in a single serial pass, in the same order as the serial code
+ * does. The output is therefore byte-for-byte identical.
+ *
+ * @fit:	Pointer to the FIT format image header
+ * @jobs:	Number of hashing threads
+ * @return: 0 on success, <0 on failure
+ */
+int fit_add_verification_data_jobs(void *fit, int jobs)
+{
+	struct fit_hash_queue queue;
+	pthread_t *threads;
+	int images_noffset, image_noffset, noffset;
+	int nthreads, i, ret = -1;
+
+	if (jobs <= 1)
+		return fit_add_verification_data(fit);
+
+	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	if (images_noffset < 0) {
+		printf("Can't find images parent node '%s' (%s)\n",
+		       FIT_IMAGES_PATH, fdt_strerror(images_noffset));
+		return images_noffset;
+	}
+
+	memset(&queue, 0, sizeof(queue));
+	queue.count = fit_collect_hash_jobs(fit, images_noffset, &queue.jobs);
+	if (queue.count < 0)
+		return -1;
+
+	nthreads = jobs < queue.count ? jobs : queue.count;
+	threads = calloc(nthreads ? nthreads : 1, sizeof(*threads));
+	if (!threads) {
+		printf("Out of memory\n");
+		goto out;
+	}
+
+	pthread_mutex_init(&queue.lock, NULL);
+	for (i = 0; i < nthreads; i++) {
+		if (pthread_create(&threads[i], NULL, fit_hash_worker,
+				   &queue)) {
+			printf("Can't create hashing thread\n");
+			nthreads = i;
+			/* let the threads we have finish the queue */
+			if (!nthreads)
+				fit_hash_worker(&queue);
+			break;
+		}
+	}
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&queue.lock);
+	free(threads);
+
+	for (i = 0; i < queue.count; i++) {
+		if (queue.jobs[i].ret) {
+			printf("Unsupported hash algorithm (%s) for '%s' hash node in '%s' image node\n",
+			       queue.jobs[i].algo, queue.jobs[i].node_name,
+			       queue.jobs[i].image_name);
+			goto out;
+		}
+	}
+
+	/* Write the values back, walking the nodes in the original order */
+	i = 0;
+	for (image_noffset = fdt_first_subnode(fit, images_noffset);
+	     image_noffset >= 0;
+	     image_noffset = fdt_next_subnode(fit, image_noffset)) {
+		for (noffset = fdt_first_subnode(fit, image_noffset);
+		     noffset >= 0;
+		     noffset = fdt_next_subnode(fit, noffset)) {
+			if (!fit_is_hash_node(fit, noffset))
+				continue;
+
+			if (fit_set_hash_value(fit, noffset,
+					       queue.jobs[i].value,
+					       queue.jobs[i].value_len)) {
+				printf("Can't set hash value for '%s' hash node in '%s' image node\n",
+				       fit_get_name(fit, noffset, NULL),
+				       fit_get_name(fit, image_noffset, NULL));
+				goto out;
+			}
+			i++;
+		}
+	}
+	ret = 0;
+
+out:
+	free(queue.jobs);
+	return ret;
+}
@@ -24,8 +24,13 @@
 #include "mkimage.h"
 #include <image.h>
 #include <version.h>
+#include <u-boot/crc.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 static void copy_file(int, const char *, int);
+static void write_data(int, const void *, int);
 static void usage(void);
 
 /* image_type_params link list to maintain registered image type supports */
@@ -37,6 +42,7 @@ struct mkimage_params params = {
 	.arch = IH_ARCH_PPC,
 	.type = IH_TYPE_KERNEL,
 	.comp = IH_COMP_GZIP,
+	.jobs = 1,
 	.dtc = MKIMAGE_DEFAULT_DTC_OPTIONS,
 	.imagename = "",
 	.imagename2 = "",
@@ -148,6 +154,7 @@ main (int argc, char **argv)
 	int ifd = -1;
 	struct stat sbuf;
 	char *ptr;
+	size_t maplen;
 	int retval = 0;
 	struct image_type_params *tparams = NULL;
 
@@ -248,6 +255,17 @@ main (int argc, char **argv)
 				params.datafile = *++argv;
 				params.fflag = 1;
 				goto NXTARG;
+			case 'j':
+				if (--argc <= 0)
+					usage ();
+				params.jobs = strtoul (*++argv, &ptr, 10);
+				if (*ptr || params.jobs < 1) {
+					fprintf (stderr,
+						"%s: invalid job count %s\n",
+						params.cmdname, *argv);
+					exit (EXIT_FAILURE);
+				}
+				goto NXTARG;
 			case 'n':
 				if (--argc <= 0)
 					usage ();
@@ -419,12 +437,7 @@ NXTARG:		;
 					size = 0;
 				}
 
-				if (write(ifd, (char *)&size, sizeof(size)) != sizeof(size)) {
-					fprintf (stderr, "%s: Write error on %s: %s\n",
-						 params.cmdname, params.imagefile,
-						 strerror(errno));
-					exit (EXIT_FAILURE);
-				}
+				write_data (ifd, &size, sizeof(size));
 
 				if (!file) {
 					break;
@@ -476,7 +489,9 @@ NXTARG:		;
 		exit (EXIT_FAILURE);
 	}
 
-	ptr = mmap(0, sbuf.st_size, PROT_READ|PROT_WRITE, MAP_SHARED, ifd, 0);
+	/* The data CRC is already known, only the header needs mapping */
+	maplen = tparams->stream_dcrc ? tparams->header_size : sbuf.st_size;
+	ptr = mmap(0, maplen, PROT_READ|PROT_WRITE, MAP_SHARED, ifd, 0);
 	if (ptr == MAP_FAILED) {
 		fprintf (stderr, "%s: Can't map %s: %s\n",
 			params.cmdname, params.imagefile, strerror(errno));
@@ -501,7 +516,7 @@ NXTARG:		;
 		exit (EXIT_FAILURE);
 	}
 
-	(void) munmap((void *)ptr, sbuf.st_size);
+	(void) munmap((void *)ptr, maplen);
 
 	/* We're a bit of paranoid */
 #if defined(_POSIX_SYNCHRONIZED_IO) && \
@@ -522,16 +537,115 @@ NXTARG:		;
 	exit (EXIT_SUCCESS);
 }
 
+/*
+ * Append data to the image, folding it into the data CRC. Writes to the
+ * output must go through here once the header has been written.
+ */
+static void
+write_data (int ifd, const void *buf, int len)
+{
+	if (write(ifd, buf, len) != len) {
+		fprintf (stderr, "%s: Write error on %s: %s\n",
+			params.cmdname, params.imagefile, strerror(errno));
+		exit (EXIT_FAILURE);
+	}
+	params.dcrc = crc32(params.dcrc, buf, len);
+}
+
+static int
+is_zero_block (const unsigned char *buf, int len)
+{
+	while (len && !*buf) {
+		buf++;
+		len--;
+	}
+	return !len;
+}
+
+/*
+ * Append a chunk of input data. Runs of all-zero blocks are skipped with
+ * lseek() instead of being written, leaving holes in the output; the file
+ * size is fixed up by copy_file() once the whole input has been copied.
+ */
+static void
+write_sparse (int ifd, const unsigned char *buf, int len)
+{
+	int run, blk;
+
+	params.dcrc = crc32(params.dcrc, buf, len);
+
+	while (len > 0) {
+		for (run = 0; run < len; run += blk) {
+			blk = len - run < MKIMAGE_SPARSE_BLOCK ?
+				      len - run : MKIMAGE_SPARSE_BLOCK;
+			if (blk < MKIMAGE_SPARSE_BLOCK ||
+			    !is_zero_block(buf + run, blk))
+				break;
+		}
+
+		if (run) {
+			if (lseek(ifd, run, SEEK_CUR) < 0) {
+				fprintf (stderr, "%s: Can't seek %s: %s\n",
+					params.cmdname, params.imagefile,
+					strerror(errno));
+				exit (EXIT_FAILURE);
+			}
+		} else {
+			for (run = 0; run < len; run += blk) {
+				blk = len - run < MKIMAGE_SPARSE_BLOCK ?
+				      len - run : MKIMAGE_SPARSE_BLOCK;
+				if (blk == MKIMAGE_SPARSE_BLOCK &&
+				    is_zero_block(buf + run, blk))
+					break;
+			}
+
+			if (write(ifd, buf, run) != run) {
+				fprintf (stderr, "%s: Write error on %s: %s\n",
+					params.cmdname, params.imagefile,
+					strerror(errno));
+				exit (EXIT_FAILURE);
+			}
+		}
+		buf += run;
+		len -= run;
+	}
+}
+
+/*
+ * Let the kernel copy the remaining input when no CRC is needed. Returns
+ * the number of bytes copied; the caller copies whatever is left (for
+ * example when the file systems don't support it) by hand.
+ */
+static off_t
+copy_range (int ifd, int dfd, off_t size)
+{
+	off_t done = 0;
+#if defined(__linux__) && defined(__NR_copy_file_range)
+	ssize_t ret;
+
+	while (done < size) {
+		ret = syscall(__NR_copy_file_range, dfd, NULL, ifd, NULL,
+			      size - done < (1 << 30) ?
+					(size_t)(size - done) : (1 << 30), 0);
+		if (ret <= 0)
+			break;
+		done += ret;
+	}
+#endif
+	return done;
+}
+
 static void
 copy_file (int ifd, const char *datafile, int pad)
 {
 	int dfd;
 	struct stat sbuf;
-	unsigned char *ptr;
+	unsigned char *buf;
 	int tail;
 	int zero = 0;
 	int offset = 0;
-	int size;
+	off_t size;
+	ssize_t len;
 	struct image_type_params *tparams = mkimage_get_type (params.type);
 
 	if (params.vflag) {
@@ -550,10 +664,10 @@ copy_file (int ifd, const char *datafile, int pad)
 		exit (EXIT_FAILURE);
 	}
 
-	ptr = mmap(0, sbuf.st_size, PROT_READ, MAP_SHARED, dfd, 0);
-	if (ptr == MAP_FAILED) {
-		fprintf (stderr, "%s: Can't read %s: %s\n",
-			params.cmdname, datafile, strerror(errno));
+	buf = malloc(MKIMAGE_COPY_CHUNK);
+	if (!buf) {
+		fprintf (stderr, "%s: Can't allocate copy buffer\n",
+			params.cmdname);
 		exit (EXIT_FAILURE);
 	}
 
@@ -572,7 +686,14 @@ copy_file (int ifd, const char *datafile, int pad)
 			exit (EXIT_FAILURE);
 		}
 
-		for (p = ptr; p < ptr + tparams->header_size; p++) {
+		if (read(dfd, buf, tparams->header_size) !=
+		    tparams->header_size) {
+			fprintf (stderr, "%s: Can't read %s: %s\n",
+				params.cmdname, datafile, strerror(errno));
+			exit (EXIT_FAILURE);
+		}
+
+		for (p = buf; p < buf + tparams->header_size; p++) {
 			if ( *p != 0xff ) {
 				fprintf (stderr,
 					"%s: Bad file: \"%s\" has invalid buffer for XIP\n",
@@ -585,23 +706,34 @@ copy_file (int ifd, const char *datafile, int pad)
 	}
 
 	size = sbuf.st_size - offset;
-	if (write(ifd, ptr + offset, size) != size) {
-		fprintf (stderr, "%s: Write error on %s: %s\n",
-			params.cmdname, params.imagefile, strerror(errno));
-		exit (EXIT_FAILURE);
-	}
-
-	if (pad && ((tail = size % 4) != 0)) {
+	if (!tparams->stream_dcrc)
+		size -= copy_range(ifd, dfd, size);
 
-		if (write(ifd, (char *)&zero, 4-tail) != 4-tail) {
-			fprintf (stderr, "%s: Write error on %s: %s\n",
-				params.cmdname, params.imagefile,
-				strerror(errno));
+	while (size > 0) {
+		len = read(dfd, buf, size < MKIMAGE_COPY_CHUNK ?
+					(size_t)size : MKIMAGE_COPY_CHUNK);
+		if (len <= 0) {
+			fprintf (stderr, "%s: Can't read %s: %s\n",
+				params.cmdname, datafile,
+				len ? strerror(errno) : "short file");
 			exit (EXIT_FAILURE);
 		}
+		write_sparse(ifd, buf, len);
+		size -= len;
 	}
 
-	(void) munmap((void *)ptr, sbuf.st_size);
+	/* a trailing hole doesn't extend the file by itself */
+	if (ftruncate(ifd, lseek(ifd, 0, SEEK_CUR)) < 0) {
+		fprintf (stderr, "%s: Can't resize %s: %s\n",
+			params.cmdname, params.imagefile, strerror(errno));
+		exit (EXIT_FAILURE);
+	}
+
+	size = sbuf.st_size - offset;
+	if (pad && ((tail = size % 4) != 0))
+		write_data (ifd, &zero, 4-tail);
+
+	free(buf);
 	(void) close (dfd);
 }
 
@@ -623,7 +755,8 @@ usage ()
 			 "          -d ==> use image data from 'datafile'\n"
 			 "          -x ==> set XIP (execute in place)\n",
 		params.cmdname);
-	fprintf (stderr, "       %s [-D dtc_options] -f fit-image.its fit-image\n",
+	fprintf (stderr, "       %s [-D dtc_options] [-j jobs] -f fit-image.its fit-image\n"
+			 "          -j ==> hash FIT images using 'jobs' threads\n",
 		params.cmdname);
 	fprintf (stderr, "       %s -V ==> print version information and exit\n",
 		params.cmdname);
@@ -59,6 +59,8 @@ static inline ulong map_to_sysmem(void *ptr)
 #define MKIMAGE_DEFAULT_DTC_OPTIONS	"-I dts -O dtb -p 500"
 #define MKIMAGE_MAX_DTC_CMDLINE_LEN	512
 #define MKIMAGE_DTC			"dtc"   /* assume dtc is in $PATH */
+#define MKIMAGE_COPY_CHUNK		(1024 * 1024)
+#define MKIMAGE_SPARSE_BLOCK		4096
 
 #define IH_ARCH_DEFAULT		IH_ARCH_INVALID
 
@@ -79,6 +81,8 @@ struct mkimage_params {
 	int arch;
 	int type;
 	int comp;
+	int jobs;
+	uint32_t dcrc;
 	char *dtc;
 	unsigned int addr;
 	unsigned int ep;
@@ -145,6 +149,13 @@ struct image_type_params {
 	 */
 	int (*vrec_header) (struct mkimage_params *,
 		struct image_type_params *);
+	/*
+	 * Set if set_header() only looks at the header and takes the data
+	 * CRC from mkimage_params.dcrc, which is computed while the data
+	 * files are being copied. The output image is then never mapped
+	 * beyond its header.
+	 */
+	int stream_dcrc;
 	/* pointer to the next registered entry in linked list */
 	struct image_type_params *next;
 };